@@ -0,0 +1,402 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2022 Madis Kaal <mast@nomad.ee>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+#pragma once
+#include <stdint.h>
+#include "vs23s010.hpp"
+
+// demo scenes shown by main.cpp, also run by the host benchmark. each
+// call to step() draws one scene and sets title of the next one.
+// DEMO_IDLE() is called in long loops, to keep watchdog happy on target
+//
+#ifndef DEMO_IDLE
+#define DEMO_IDLE()
+#endif
+
+extern const FONT pal10_font;
+
+template <class S>
+class DemoScenes
+{
+    S &screen;
+    uint8_t state;
+    uint8_t beginc;
+    uint32_t seed;
+
+public:
+
+    const char *title;
+
+    DemoScenes(S &s) : screen(s), state(255), beginc(' '), seed(734518),
+                       title("Welcome to the show")
+    {
+    }
+
+    /* The state must be initialized to non-zero */
+    uint32_t xrandom()
+    {
+        /* Algorithm "xor" from p. 4 of Marsaglia, "Xorshift RNGs" */
+        uint32_t x = seed;
+        x ^= x << 13;
+        x ^= x >> 17;
+        x ^= x << 5;
+        seed = x;
+        return x;
+    }
+
+    int16_t slen(const char *s)
+    {
+      int16_t l=0;
+      while (s && *s++)
+          l++;
+      return l; 
+    }
+
+    void mandel(void)
+    {
+        // from http://warp.povusers.org/Mandelbrot/
+        float MinRe = -2.0;
+        float MaxRe = 1.0;
+        float MinIm = -1.2;
+        float MaxIm = 1.2;
+        float Re_factor = (MaxRe-MinRe)/((float)(screen.width-1));
+        float Im_factor = (MaxIm-MinIm)/((float)(screen.height-1));
+        uint16_t MaxIterations = 128;
+        uint16_t n;
+        // the set is symmetric, so only top half is calculated and every
+        // finished row is queued for block mover to copy to bottom half
+        // while the next one is being calculated
+        for(int16_t y=0; y<(screen.height+1)/2; ++y) {
+            float c_im = MaxIm - y*Im_factor;
+            for(int16_t x=0; x<screen.width; ++x) {
+                float c_re = MinRe + x*Re_factor;
+                float Z_re = c_re;
+                float Z_im = c_im;
+                for(n=0; n<MaxIterations; ++n)
+                {
+                    float Z_re2 = Z_re*Z_re, Z_im2 = Z_im*Z_im;
+                    if(Z_re2 + Z_im2 > 4)
+                        break;
+                    Z_im = 2*Z_re*Z_im + c_im;
+                    Z_re = Z_re2 - Z_im2 + c_re;
+                }
+                if (n!=MaxIterations)
+                    screen.set_pixel(x, y, 200 - n);
+                screen.blit_drain();
+            }
+            screen.queue_copy(0,y,screen.width-1,y,0,screen.height-1-y);
+        }
+        screen.blit_flush();
+    }
+
+#ifdef TCNT1
+#define TIMED_PIXELS 1024
+    // set_pixel micro-benchmark. timer 1 counts at F_CPU/64 while pixels
+    // are drawn along a row, along a column, and scattered around the screen.
+    // returns CPU cycles per pixel, including the SPI transfer. build with
+    // PICLINE_POW2 defined to compare line addressing by shift with the
+    // stepped addressing used for unpadded lines
+    uint16_t pixel_cycles(uint8_t mode)
+    {
+        int16_t x=0,y=0;
+        TCCR1A=0;
+        TCCR1B=3;
+        TCNT1=0;
+        for (uint16_t i=0;i<TIMED_PIXELS;i++) {
+            screen.set_pixel(x,y,i);
+            switch (mode) {
+                case 0:
+                    if (++x>=screen.width) {
+                        x=0;
+                        y++;
+                    }
+                    break;
+                case 1:
+                    if (++y>=screen.height) {
+                        y=0;
+                        x++;
+                    }
+                    break;
+                default:
+                    x+=97;
+                    if (x>=screen.width)
+                        x-=screen.width;
+                    y+=61;
+                    if (y>=screen.height)
+                        y-=screen.height;
+                    break;
+            }
+        }
+        uint16_t t=TCNT1;
+        TCCR1B=0;
+        return (uint32_t)t*64/TIMED_PIXELS;
+    }
+#endif
+
+    void step(void)
+    {
+        int16_t x1;
+        int16_t y1;
+        int16_t x2,y2,c,i;
+        switch (state) {
+            default:
+                state=0;
+                title="Palette";
+                break;
+            case 0:
+                for (y1=0;y1<16;y1++) {
+                    for (x1=0;x1<16;x1++) {
+                        screen.filled_rect(x1*20+1,y1*15+1,x1*20+17+1,y1*15+13+1,y1*16+x1);
+                    }
+                }
+                state++;
+                title="White screen";
+                break;
+            case 1:
+                screen.filled_rect(0,0,screen.width-1,screen.height-1,15);
+                state++;
+                title="Vertical bars";
+                break;
+            case 2:
+                for (x1=0;x1<screen.width;x1+=32) {
+                    screen.filled_rect(x1,0,x1+31,screen.height-1,(x1&32)?15:0);
+                }
+                state++;
+                title="Line mesh";
+                break;
+            case 3:
+                for (x1=0;x1<screen.width;x1+=7) {
+                    screen.vline(x1,0,screen.height-1,15);
+                }
+                for (y1=0;y1<screen.height;y1+=7) {
+                    screen.hline(0,y1,screen.width-1,15);
+                }
+                state++;
+                title="Random rectangles";
+                break;
+            case 4:
+                for (i=0;i<1000;i++) {
+                    x1=xrandom()%screen.width;
+                    y1=xrandom()%screen.height;
+                    x2=x1+xrandom()%(screen.width-x1);
+                    y2=y1+xrandom()%(screen.height-y1);
+                    c=xrandom()&255;
+                    screen.filled_rect(x1,y1,x2,y2,c);
+                    DEMO_IDLE();
+                }
+                state++;
+                title="Strings and numbers";
+                break;
+            case 5:
+                screen.set_pos(0,40);
+                screen.set_font(&pal10_font);
+                screen.puts("\r\nScreen width: ");
+                screen.printn(screen.width);
+                screen.puts("\r\nScreen height: ");
+                screen.printn(screen.height);
+                screen.puts("\r\nLine size: ");
+                screen.printn(screen.linesize);
+                screen.puts("\r\nPICLINE_START: ");
+                screen.printn(PICLINE_START);
+                screen.puts("\r\nPICLINE_TOTAL_BYTES: ");
+                screen.printn(PICLINE_TOTAL_BYTES);
+                screen.puts("\r\nSTARTPIX: ");
+                screen.printn(STARTPIX);
+                screen.puts("\r\nENDPIX: ");
+                screen.printn(ENDPIX);
+            
+                state++;
+                title="Slow scroll";
+                break;
+            case 6:
+                #define NEXT(c) ((((c+1)-' ')%96)+' ') 
+                c=beginc;
+                screen.set_pos(0,0);
+                for (y1=0;y1<23;y1++) {
+                    uint8_t cx=c;
+                    for (x1=0;x1<40;x1++) {
+                        screen.putc(cx);
+                        cx=NEXT(cx);
+                    }
+                    screen.puts("\r\n");
+                    c=NEXT(c);
+                }
+                beginc=NEXT(beginc);
+                for (i=0;i<100;i++) {
+                    screen.scroll_down(1);
+                    DEMO_IDLE();
+                }
+                for (i=0;i<100;i++) {
+                    screen.scroll_up(1);
+                    DEMO_IDLE();
+                }
+                state++;
+                title="Scrolling text";
+                break;
+            case 7:
+                for (i=0;i<100;i++) {
+                    screen.set_pos(0,screen.height-11);
+                    c=beginc;
+                    for (y1=0;y1<1;y1++) {
+                        uint8_t cx=c;
+                        for (x1=0;x1<40;x1++) {
+                            screen.putc(cx);
+                            cx=NEXT(cx);
+                        }
+                        screen.puts("\r\n");
+                        c=NEXT(c);
+                    }
+                    beginc=NEXT(beginc);
+                    screen.scroll_up(10);
+                }
+                state++;
+                title="Vertical lines";
+                break;
+            case 8:
+                for (i=1;i<screen.height;i+=2) {
+                    screen.vline(i+39,0,i,15);
+                }
+                state++;
+                title="Horizontal lines";
+                break;
+            case 9:
+                for (i=1;i<screen.height;i+=2) {
+                    screen.hline(0,i,i,15);
+                    screen.hline(screen.width-i-1,screen.height-i,screen.width-1,15);
+                }
+                state++;
+                title="Widening rectangles";
+                break;
+            case 10:
+                screen.filled_rect(20,10,20,screen.height-20,15);
+                screen.filled_rect(60,10,61,screen.height-20,15);
+                screen.filled_rect(100,10,102,screen.height-20,15);
+                screen.filled_rect(140,10,143,screen.height-20,15);
+                screen.filled_rect(180,10,184,screen.height-20,15);
+                screen.filled_rect(220,10,225,screen.height-20,15);
+                screen.filled_rect(260,10,266,screen.height-20,15);
+                title="Mandelbrot";
+                state++;
+                break;
+            case 11:
+                mandel();
+                state++;
+                title="Sprites";
+                break;
+            case 12:
+                // sprite image is drawn on screen and grabbed from there
+                screen.filled_rect(0,0,15,15,0);
+                screen.rect(0,0,15,15,15);
+                screen.filled_rect(4,4,11,11,12);
+                screen.sprite_grab(0,0,0,16,16);
+                for (x1=0;x1<screen.width;x1+=32) {
+                    screen.filled_rect(x1,0,x1+31,screen.height-1,(x1&32)?15:0);
+                }
+                x1=0;
+                y1=0;
+                x2=3;
+                y2=2;
+                for (i=0;i<200;i++) {
+                    screen.sprite_move(0,x1,y1);
+                    x1+=x2;
+                    y1+=y2;
+                    if (x1<0 || x1>screen.width-16) {
+                        x2=-x2;
+                        x1+=x2;
+                    }
+                    if (y1<0 || y1>screen.height-16) {
+                        y2=-y2;
+                        y1+=y2;
+                    }
+                    DEMO_IDLE();
+                }
+                screen.sprite_hide(0);
+                state++;
+                title="Tile board";
+                break;
+            case 13:
+                {
+                    // 16x16 tiles drawn on screen and grabbed from there,
+                    // board of 16x12 cells where random cells change
+                    uint8_t board[16*12];
+                    screen.tile_map(board,16,12,16,16,32,24);
+                    for (c=0;c<4;c++) {
+                        screen.filled_rect(0,0,15,15,c*4);
+                        screen.rect(0,0,15,15,15);
+                        screen.filled_rect(6-c,6-c,9+c,9+c,15-c*4);
+                        screen.tile_grab(c,0,0);
+                    }
+                    screen.filled_rect(0,0,15,15,0);
+                    for (i=0;i<16*12;i++)
+                        board[i]=i&3;
+                    screen.tile_map(board,16,12,16,16,32,24);
+                    screen.tile_update();
+                    for (i=0;i<200;i++) {
+                        for (c=0;c<4;c++)
+                            screen.tile_set(xrandom()%16,xrandom()%12,xrandom()&3);
+                        screen.tile_update();
+                        DEMO_IDLE();
+                    }
+                    screen.tile_map(NULL,0,0,0,0,0,0);
+                }
+                state++;
+                title="Gauges";
+                break;
+            case 14:
+                // dials with scale arc and value as pie segment going
+                // clockwise from lower left
+                for (i=0;i<6;i++) {
+                    x1=53+(i%3)*107;
+                    y1=65+(i/3)*110;
+                    screen.filled_circle(x1,y1,48,8);
+                    screen.circle(x1,y1,48,15);
+                    screen.arc(x1,y1,44,-45,225,15);
+                    c=xrandom()%270;
+                    screen.pie(x1,y1,40,225-c,225,(i&1)?12:10);
+                    screen.filled_circle(x1,y1,6,15);
+                }
+                state++;
+                title="Pixel timing";
+                break;
+    #ifdef TCNT1
+            case 15:
+                x1=pixel_cycles(0);
+                y1=pixel_cycles(1);
+                x2=pixel_cycles(2);
+                screen.filled_rect(0,0,screen.width-1,screen.height-1,0);
+                screen.set_pos(0,40);
+                screen.puts("\r\nLine size: ");
+                screen.printn(screen.linesize);
+                screen.puts("\r\nCycles per pixel along row: ");
+                screen.printn(x1);
+                screen.puts("\r\nCycles per pixel along column: ");
+                screen.printn(y1);
+                screen.puts("\r\nCycles per scattered pixel: ");
+                screen.printn(x2);
+                state++;
+                title="The end";
+                break;
+    #endif
+        }
+    }
+};
@@ -36,4 +36,16 @@ typedef struct __attribute__((packed)) {
   const uint8_t *bitmaps_P[];  // pointer to character bitmaps, only one for fixed width
 } FONT;
 
+// font laid out for loading into VS23S010 video memory in one go. glyphs
+// are in rows of cells as wide as the widest character, one bit per pixel,
+// each atlas line is (cellw*cells+7)/8 bytes. lines can be PackBits
+// compressed as one stream
+typedef struct __attribute__((packed)) {
+  const FONT *font;        // the font the atlas is made of
+  uint8_t cellw,cells;     // width of glyph cell and number of cells on a row
+  uint8_t rows;            // number of rows of cells
+  uint8_t packed;          // 1 if atlas is compressed
+  const uint8_t *atlas_P;  // pointer to atlas lines
+} FONTATLAS;
+
 #endif
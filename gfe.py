@@ -79,6 +79,8 @@ class App(Tk):
     button.grid(row=0,column=6,sticky=W+N)
     button=Button(buttonframe,text="Export for OLED",command=self.exportoled)
     button.grid(row=0,column=7,sticky=W+N)
+    button=Button(buttonframe,text="Export for VS23",command=self.exportvs23)
+    button.grid(row=0,column=8,sticky=W+N)
     
     self.stride=13
     self.sampletexts=[]
@@ -384,6 +386,104 @@ class App(Tk):
       f.write(widths)
       f.write(font)
       
+  # VS23S010 driver keeps fonts in video memory in rows of cells as wide
+  # as the widest character, as many cells on a row as fit in its bitmap
+  # area. that is 320 pixels, or 183 with lines padded to power of two.
+  # this exports the font laid out the same way with one bit per pixel,
+  # so that the driver can write it to video memory line by line without
+  # working out where every glyph goes. the lines can be compressed with
+  # PackBits. the atlas refers to the font from regular export for
+  # character widths
+  #
+  def exportvs23(self):
+    self.changeto(self.currentchar)
+    begin=self.first_defined()
+    if begin==1 or begin==33:
+      begin-=1
+    end=self.last_defined()
+    if begin==None or end==None:
+      self.status("No defined chars")
+      return
+    areawidth=self.askvalue("Bitmap area width in pixels (183 with lines padded to power of two)","320")
+    if not areawidth:
+      return
+    try:
+      areawidth=int(areawidth)
+    except ValueError:
+      self.status("Bad bitmap area width")
+      return
+    cellw=max(self.widths[begin:end+1])
+    cells=int(areawidth/cellw)
+    if cells<1:
+      messagebox.showerror(title="Error",message="Characters wider than bitmap area")
+      return
+    rows=int((end-begin+cells)/cells)
+    if rows>255:
+      messagebox.showerror(title="Error",message="Too many rows of characters")
+      return
+    packed=messagebox.askyesno(title="Export for VS23",message="Compress atlas?")
+    name=os.path.basename(self.filename).partition(".")[0]
+    data=bytearray()
+    linebytes=int((cells*cellw+7)/8)
+    for r in range(rows):
+      for y in range(self.fontheight):
+        bits=[0]*(linebytes*8)
+        for i in range(cells):
+          c=begin+r*cells+i
+          if c>end:
+            break
+          d=self.font[c][y]
+          for x in range(self.widths[c]):
+            if d&(0x80000000>>x):
+              bits[i*cellw+x]=1
+        for i in range(linebytes):
+          b=0
+          for j in range(8):
+            b=(b<<1)|bits[i*8+j]
+          data.append(b)
+    if packed:
+      data=self.packbits(data)
+    atlas="uint8_t const %s_atlas_lines[] PROGMEM = {\n"%name
+    for i in range(0,len(data),16):
+      atlas+="  "+"".join(["0x%02x,"%b for b in data[i:i+16]])+"\n"
+    atlas+="};\n\n"
+    font="const FONTATLAS %s_atlas = {\n"%name
+    font+=" &%s_font,\n"%name
+    font+=" %d,%d,\n"%(cellw,cells)
+    font+=" %d,%d,\n"%(rows,1 if packed else 0)
+    font+=" %s_atlas_lines\n"%name
+    font+="};\n"
+    with open("%s.vs23.c"%self.filename,"wt") as f:
+      f.write('#include "font.h"\n\n')
+      f.write("extern const FONT %s_font;\n\n"%name)
+      f.write(atlas)
+      f.write(font)
+
+  # PackBits, header byte 0..127 is followed by 1..128 bytes of literal
+  # data, header -1..-127 by one byte that is repeated 2..128 times
+  #
+  def packbits(self,data):
+    out=bytearray()
+    i=0
+    while i<len(data):
+      n=1
+      while i+n<len(data) and n<128 and data[i+n]==data[i]:
+        n+=1
+      if n>1:
+        out.append(257-n)
+        out.append(data[i])
+        i+=n
+        continue
+      j=i
+      while j<len(data) and j-i<128:
+        if j+1<len(data) and data[j+1]==data[j]:
+          break
+        j+=1
+      out.append(j-i-1)
+      out.extend(data[i:j])
+      i=j
+    return out
+
   def changeto(self,charnum):
     if self.currentchar!=None:
       self.font[self.currentchar]=list(self.cell)
@@ -0,0 +1,7 @@
+// program memory access for host build, on PC flash and RAM are the same
+#pragma once
+#include <stdint.h>
+#define PROGMEM
+#define pgm_read_byte(p) (*(const uint8_t*)(p))
+#define pgm_read_word(p) (*(const uint16_t*)(p))
+#define pgm_read_ptr(p) (*(void* const*)(p))
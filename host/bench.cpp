@@ -0,0 +1,297 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2022 Madis Kaal <mast@nomad.ee>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "hostscreen.hpp"
+#include "demo.hpp"
+
+// SPI cost of drawing primitives and demo scenes on emulated chip. for
+// each one the chip selects, command and payload bytes, CURLINE polls
+// and block mover starts are counted, and the time estimated for given
+// CPU and SPI clock. emulated time also includes waiting for block mover.
+//
+// usage: bench [-f cpu_hz] [-s spi_hz] [-b cycles] [-c cycles] [-m width] [-l] [-o]
+//   -f CPU clock, default F_CPU
+//   -s SPI clock, default half of CPU clock
+//   -b CPU cycles lost between bytes, default 2
+//   -c CPU cycles for every chip select, default 20
+//   -m narrowest block move that works on emulated chip, default all.
+//      over 8 the block mover is not used and moves are done in software
+//   -l block mover of emulated chip only does moves of one line
+//   -o block mover of emulated chip cannot move between overlapping areas
+
+HostScreen screen;
+
+extern const FONTATLAS pal10_atlas;
+
+static double cpu_hz=F_CPU;
+static double spi_hz=F_CPU/2;
+static double byte_cycles=2;
+static double select_cycles=20;
+
+static uint32_t seed=734518;
+
+static uint32_t xrandom()
+{
+    seed^=seed<<13;
+    seed^=seed>>17;
+    seed^=seed<<5;
+    return seed;
+}
+
+static double estimate_ms(const SPIStats &s)
+{
+    return (s.bytes()*8/spi_hz+
+            (s.bytes()*byte_cycles+s.selects*select_cycles)/cpu_hz)*1000.0;
+}
+
+static void header(const char *what)
+{
+    printf("\n%-22s %6s %8s %8s %9s %7s %7s %9s %9s\n",what,"calls",
+        "selects","command","payload","polls","blits","est ms","emu ms");
+}
+
+// print counts of what was done since start, per call
+struct Measure {
+    const char *name;
+    uint32_t calls;
+    SPIStats start;
+    uint64_t start_ns;
+
+    Measure(const char *n,uint32_t c) : name(n), calls(c),
+        start(screen.stats), start_ns(screen.chip.now_ns)
+    {
+    }
+
+    ~Measure()
+    {
+        screen.blit_flush();
+        if (!calls)
+            return;
+        SPIStats d=screen.stats-start;
+        double n=calls;
+        printf("%-22s %6u %8.1f %8.1f %9.1f %7.1f %7.1f %9.3f %9.3f\n",
+            name,calls,d.selects/n,d.commands/n,d.payload/n,d.polls/n,
+            d.blits/n,estimate_ms(d)/n,
+            (screen.chip.now_ns-start_ns)/1e6/n);
+    }
+};
+
+static void primitives()
+{
+    int16_t i;
+    header("per call");
+    {
+        Measure m("filled_rect",100);
+        for (i=0;i<100;i++) {
+            int16_t x=xrandom()%screen.width,y=xrandom()%screen.height;
+            screen.filled_rect(x,y,x+xrandom()%(screen.width-x),
+                y+xrandom()%(screen.height-y),xrandom());
+        }
+    }
+    {
+        Measure m("filled_rect full",10);
+        for (i=0;i<10;i++)
+            screen.filled_rect(0,0,screen.width-1,screen.height-1,i);
+    }
+    {
+        Measure m("vline",100);
+        for (i=0;i<100;i++)
+            screen.vline(xrandom()%screen.width,xrandom()%screen.height,
+                xrandom()%screen.height,xrandom());
+    }
+    {
+        Measure m("filled_rect narrow",100);
+        for (i=0;i<100;i++) {
+            int16_t x=xrandom()%screen.width,y=xrandom()%screen.height;
+            screen.filled_rect(x,y,x+xrandom()%8,y+xrandom()%(screen.height-y),
+                xrandom());
+        }
+    }
+    {
+        Measure m("rect",100);
+        for (i=0;i<100;i++) {
+            int16_t x=xrandom()%screen.width,y=xrandom()%screen.height;
+            screen.rect(x,y,x+xrandom()%(screen.width-x),
+                y+xrandom()%(screen.height-y),xrandom());
+        }
+    }
+    {
+        Measure m("line",100);
+        for (i=0;i<100;i++)
+            screen.line(xrandom()%screen.width,xrandom()%screen.height,
+                xrandom()%screen.width,xrandom()%screen.height,xrandom());
+    }
+    {
+        Measure m("fill_triangle",100);
+        for (i=0;i<100;i++)
+            screen.fill_triangle(xrandom()%screen.width,xrandom()%screen.height,
+                xrandom()%screen.width,xrandom()%screen.height,
+                xrandom()%screen.width,xrandom()%screen.height,xrandom());
+    }
+    {
+        Measure m("circle",100);
+        for (i=0;i<100;i++)
+            screen.circle(xrandom()%screen.width,xrandom()%screen.height,
+                xrandom()%100,xrandom());
+    }
+    {
+        Measure m("filled_circle",100);
+        for (i=0;i<100;i++)
+            screen.filled_circle(xrandom()%screen.width,xrandom()%screen.height,
+                xrandom()%100,xrandom());
+    }
+    {
+        Measure m("pie",100);
+        for (i=0;i<100;i++)
+            screen.pie(xrandom()%screen.width,xrandom()%screen.height,
+                xrandom()%100,xrandom()%360,xrandom()%360,xrandom());
+    }
+    {
+        static uint8_t image[32*32];
+        for (i=0;i<(int16_t)sizeof(image);i++)
+            image[i]=xrandom();
+        {
+            Measure m("draw_bitmap 1bpp",10);
+            for (i=0;i<10;i++)
+                screen.draw_bitmap(xrandom()%screen.width,xrandom()%screen.height,
+                    32,32,image,1);
+        }
+        {
+            Measure m("draw_bitmap 8bpp",10);
+            for (i=0;i<10;i++)
+                screen.draw_bitmap(xrandom()%screen.width,xrandom()%screen.height,
+                    32,32,image,8);
+        }
+    }
+    {
+        Measure m("set_font",1);
+        screen.set_font(&pal10_font);
+    }
+    bool atlas;
+    {
+        // glyphs of atlas font in colors not used before
+        screen.set_colors(14,1);
+        Measure m("set_font atlas",1);
+        atlas=screen.set_font(&pal10_atlas);
+    }
+    if (!atlas)
+        printf("atlas does not match bitmap area, glyphs rendered on first use\n");
+    screen.set_colors(15,0);
+    {
+        Measure m("blitchar",100);
+        for (i=0;i<100;i++)
+            screen.blitchar(' '+i%96,(i%40)*8,(i/40)*10,&pal10_font);
+    }
+    {
+        Measure m("vblitchar",100);
+        for (i=0;i<100;i++)
+            screen.vblitchar(' '+i%96,(i%40)*8,(i/40)*10);
+    }
+    for (uint8_t ring=0;ring<2;ring++) {
+        screen.set_scroll_mode(ring);
+        {
+            Measure m(ring?"scroll_up ring":"scroll_up",10);
+            for (i=0;i<10;i++)
+                screen.scroll_up(10);
+        }
+        {
+            Measure m(ring?"scroll_down ring":"scroll_down",10);
+            for (i=0;i<10;i++)
+                screen.scroll_down(10);
+        }
+    }
+}
+
+// same scenes in the same order as main.cpp shows them
+static void scenes()
+{
+    DemoScenes<HostScreen> demo(screen);
+    header("demo scene");
+    screen.set_scroll_mode(false);
+    screen.set_font(&pal10_font);
+    demo.step(); // first step only picks the first scene
+    bool more=true;
+    while (more) {
+        const char *title=demo.title;
+        screen.filled_rect(0,0,screen.width-1,screen.height-1,0);
+        Measure m(title,1);
+        demo.step();
+        // scenes that cannot run on host wrap around to the beginning
+        if (!strcmp(demo.title,"Palette")) {
+            m.calls=0;
+            more=false;
+        }
+    }
+}
+
+int main(int argc,char *argv[])
+{
+    int c;
+    bool spiset=false;
+    while ((c=getopt(argc,argv,"f:s:b:c:m:lo"))!=-1) {
+        switch (c) {
+            case 'f':
+                cpu_hz=atof(optarg);
+                break;
+            case 's':
+                spi_hz=atof(optarg);
+                spiset=true;
+                break;
+            case 'b':
+                byte_cycles=atof(optarg);
+                break;
+            case 'c':
+                select_cycles=atof(optarg);
+                break;
+            case 'm':
+                screen.chip.min_move_width=atoi(optarg);
+                break;
+            case 'l':
+                screen.chip.single_line_moves=true;
+                break;
+            case 'o':
+                screen.chip.overlap_fails=true;
+                break;
+            default:
+                fprintf(stderr,"usage: %s [-f cpu_hz] [-s spi_hz] [-b cycles] [-c cycles] [-m width] [-l] [-o]\n",argv[0]);
+                return 1;
+        }
+    }
+    if (!spiset)
+        spi_hz=cpu_hz/2;
+    screen.chip.spi_ns_per_byte=8e9/spi_hz;
+    printf("CPU %.0f Hz, SPI %.0f Hz, %.0f cycles per byte, %.0f per select\n",
+        cpu_hz,spi_hz,byte_cycles,select_cycles);
+    header("startup");
+    {
+        Measure m("init",1);
+        screen.init();
+    }
+    primitives();
+    scenes();
+    return 0;
+}
@@ -0,0 +1,491 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2022 Madis Kaal <mast@nomad.ee>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <algorithm>
+#include "hostscreen.hpp"
+
+// checks drawing on emulated chip against reference picture in RAM. the
+// reference is drawn from the definition of each shape, every pixel on
+// its own, without the spans, edge tables and block moves of the driver.
+// the number of pixels that differ is printed for every check, after a
+// difference the reference is taken from the screen so that one wrong
+// shape is not counted again with the ones after it.
+// all checks are made with block mover of the emulated chip failing in
+// each of the ways it can, after checking that blitter_probe() finds out
+// what the mover does, and that no move the mover gets wrong is made.
+// usage: check
+// exit status is 1 if any check failed
+
+HostScreen screen;
+
+static uint8_t ref[YPIXELS][XPIXELS];
+static uint32_t seed=734518;
+static int failed;
+
+static uint32_t xrandom()
+{
+    seed^=seed<<13;
+    seed^=seed>>17;
+    seed^=seed<<5;
+    return seed;
+}
+
+// random number from lo to hi
+static int16_t between(int16_t lo,int16_t hi)
+{
+    return lo+(int16_t)(xrandom()%(uint32_t)(hi-lo+1));
+}
+
+static void plot(int32_t x,int32_t y,uint8_t color)
+{
+    if (x>=0 && x<XPIXELS && y>=0 && y<YPIXELS)
+        ref[y][x]=color;
+}
+
+static void clear()
+{
+    screen.filled_rect(0,0,screen.width-1,screen.height-1,0);
+    memset(ref,0,sizeof(ref));
+}
+
+// pixels that differ from reference
+static uint32_t compare()
+{
+    uint32_t bad=0;
+    screen.blit_flush();
+    for (int16_t y=0;y<YPIXELS;y++) {
+        for (int16_t x=0;x<XPIXELS;x++) {
+            uint8_t p=screen.pixel(x,y);
+            if (p!=ref[y][x]) {
+                ref[y][x]=p;
+                bad++;
+            }
+        }
+    }
+    return bad;
+}
+
+static void report(const char *what,uint32_t shapes,uint32_t bad)
+{
+    printf("%-28s %6u %8u %s\n",what,shapes,bad,bad?"FAIL":"ok");
+    if (bad)
+        failed=1;
+}
+
+// floor of 16.16 fixed point
+static int32_t whole(int64_t x)
+{
+    return (int32_t)((x>=0)?x/65536:-((-x+65535)/65536));
+}
+
+// polygon by its definition: on every line the crossings of edges that
+// are not horizontal are paired from left to right, and pixels from one
+// crossing of a pair to the other are filled. edge crosses lines from its
+// top end to its bottom end, at x of the line through the ends plus half
+// a pixel, with step per line rounded to 16.16 fixed point as the driver
+// does it. where the outline goes on through a vertex in the same
+// direction, the line of the vertex belongs to the lower edge only
+static void ref_polygon(const int16_t *p,uint8_t n,uint8_t color)
+{
+    struct {
+        int32_t xt,yt,yb;
+        int64_t dx;
+        bool down;
+    } e[POLYGON_EDGES];
+    uint8_t ne=0;
+    for (uint8_t i=0;i<n;i++) {
+        int32_t xa=p[2*i],ya=p[2*i+1];
+        int32_t xb=p[2*((i+1)%n)],yb=p[2*((i+1)%n)+1];
+        if (ya==yb)
+            continue;
+        e[ne].down=(ya<yb);
+        if (!e[ne].down) {
+            std::swap(xa,xb);
+            std::swap(ya,yb);
+        }
+        e[ne].xt=xa;
+        e[ne].yt=ya;
+        e[ne].yb=yb;
+        e[ne].dx=((int64_t)(xb-xa)*65536)/(yb-ya);
+        ne++;
+    }
+    // of the two edges at a vertex the one above it is shortened, that is
+    // the one before when going down and the one after when going up
+    int32_t ybot[POLYGON_EDGES];
+    for (uint8_t k=0;k<ne;k++)
+        ybot[k]=e[k].yb;
+    for (uint8_t k=0;k<ne;k++) {
+        uint8_t next=(k+1)%ne;
+        if (e[k].down && e[next].down)
+            ybot[k]--;
+        if (!e[k].down && !e[next].down)
+            ybot[next]--;
+    }
+    for (int32_t y=0;y<YPIXELS;y++) {
+        int64_t x[POLYGON_EDGES];
+        uint8_t nx=0;
+        for (uint8_t k=0;k<ne;k++) {
+            if (y>=e[k].yt && y<=ybot[k])
+                x[nx++]=(int64_t)e[k].xt*65536+0x8000+e[k].dx*(y-e[k].yt);
+        }
+        std::sort(x,x+nx);
+        for (uint8_t i=0;i+1<nx;i+=2) {
+            for (int32_t px=whole(x[i]);px<=whole(x[i+1]);px++)
+                plot(px,y,color);
+        }
+    }
+}
+
+static void check_polygon(const char *what,const int16_t *p,uint8_t n,uint32_t &shapes,uint32_t &bad)
+{
+    uint8_t color=1+xrandom()%255;
+    screen.fill_polygon(p,n,color);
+    ref_polygon(p,n,color);
+    shapes++;
+    uint32_t d=compare();
+    if (d)
+        printf("  %s: %u pixels differ\n",what,d);
+    bad+=d;
+}
+
+// concave and self-intersecting polygons, ones that go through the same
+// vertex twice, with horizontal edges and vertices on the same line, and
+// random ones reaching off screen
+static void polygons()
+{
+    static const int16_t comb[]={20,20,60,20,60,100,100,100,100,20,140,20,140,140,20,140};
+    static const int16_t arrow[]={170,20,300,80,170,140,210,80};
+    static const int16_t star[]={80,160,110,235,40,185,120,185,50,235};
+    static const int16_t bowtie[]={150,150,240,230,240,150,150,230};
+    static const int16_t eight[]={250,150,280,190,310,150,310,230,280,190,250,230};
+    static const int16_t notch[]={10,10,50,10,50,30,80,30,80,10,120,10,120,60,10,60};
+    static const int16_t zigzag[]={180,10,200,40,220,10,240,40,260,10,280,40,300,10,300,70,180,70};
+    static const int16_t spike[]={20,200,60,160,60,200,100,160,100,230,20,230};
+    uint32_t shapes=0,bad=0;
+    clear();
+    check_polygon("comb",comb,8,shapes,bad);
+    check_polygon("arrow",arrow,4,shapes,bad);
+    check_polygon("star",star,5,shapes,bad);
+    check_polygon("bowtie",bowtie,4,shapes,bad);
+    check_polygon("figure eight",eight,6,shapes,bad);
+    check_polygon("notch",notch,8,shapes,bad);
+    check_polygon("zigzag",zigzag,9,shapes,bad);
+    check_polygon("spike",spike,6,shapes,bad);
+    report("fill_polygon shapes",shapes,bad);
+    shapes=bad=0;
+    clear();
+    for (uint16_t i=0;i<400;i++) {
+        int16_t p[2*POLYGON_EDGES];
+        uint8_t n=3+xrandom()%(POLYGON_EDGES-2);
+        for (uint8_t j=0;j<n;j++) {
+            // some vertices repeated, some on same line as previous
+            if (j && !(xrandom()%6)) {
+                uint8_t k=xrandom()%j;
+                p[2*j]=p[2*k];
+                p[2*j+1]=p[2*k+1];
+            }
+            else {
+                p[2*j]=between(-60,XPIXELS+60);
+                p[2*j+1]=(j && !(xrandom()%4))?p[2*j-1]:between(-60,YPIXELS+60);
+            }
+        }
+        check_polygon("random",p,n,shapes,bad);
+    }
+    report("fill_polygon random",shapes,bad);
+    shapes=bad=0;
+    clear();
+    for (uint16_t i=0;i<400;i++) {
+        int16_t p[6];
+        for (uint8_t j=0;j<6;j+=2) {
+            p[j]=between(-40,XPIXELS+40);
+            p[j+1]=between(-40,YPIXELS+40);
+        }
+        uint8_t color=1+xrandom()%255;
+        screen.fill_triangle(p[0],p[1],p[2],p[3],p[4],p[5],color);
+        ref_polygon(p,3,color);
+        shapes++;
+        bad+=compare();
+    }
+    report("fill_triangle",shapes,bad);
+}
+
+// point x,y from centre is in ellipse when
+// ry*ry*x*x+rx*rx*y*y<=rx*rx*ry*ry+rx*ry*min(rx,ry)
+static bool in_ellipse(int32_t x,int32_t y,int32_t rx,int32_t ry)
+{
+    if (x<-rx || x>rx || y<-ry || y>ry)
+        return false;
+    int64_t rx2=(int64_t)rx*rx,ry2=(int64_t)ry*ry;
+    return ry2*x*x+rx2*y*y<=rx2*ry2+(int64_t)rx*ry*std::min(rx,ry);
+}
+
+// sine of 0..90 degrees scaled to 255 and rounded
+static int32_t sine(int32_t angle)
+{
+    return (int32_t)floor(255.0*sin(angle*M_PI/180.0)+0.5);
+}
+
+// direction of angle as cosine and sine scaled to 255, y upwards. angle
+// is taken to first quadrant, so that the rounding is the same in all
+static void direction(int32_t angle,int32_t &c,int32_t &s)
+{
+    angle%=360;
+    if (angle<0)
+        angle+=360;
+    int32_t a=angle%90;
+    int32_t sa=sine(a),ca=sine(90-a);
+    switch (angle/90) {
+        case 0: c=ca; s=sa; break;
+        case 1: c=-sa; s=ca; break;
+        case 2: c=-ca; s=-sa; break;
+        default: c=sa; s=-ca; break;
+    }
+}
+
+// ellipse, or part of circle from start to end angle counterclockwise,
+// pixel by pixel. outline has the points in ellipse that have a point
+// outside next to them, away from centre across or along the line. a
+// point is in the sector when it is counterclockwise from the start
+// direction and clockwise from the end one by up to half circle, for
+// sectors over 180 degrees either of these will do
+static void ref_ellipse(int32_t xc,int32_t yc,int32_t rx,int32_t ry,bool fill,bool sector,int32_t start,int32_t end,uint8_t color)
+{
+    int32_t span=end-start;
+    if (span>=360 || span<=-360)
+        sector=false;
+    span%=360;
+    if (span<0)
+        span+=360;
+    if (sector && !span)
+        return;
+    int32_t c0,s0,c1,s1;
+    direction(start,c0,s0);
+    direction(end,c1,s1);
+    for (int32_t y=-ry;y<=ry;y++) {
+        for (int32_t x=-rx;x<=rx;x++) {
+            if (!in_ellipse(x,y,rx,ry))
+                continue;
+            if (!fill && in_ellipse(abs(x)+1,y,rx,ry) &&
+                in_ellipse(x,abs(y)+1,rx,ry))
+                continue;
+            if (sector) {
+                int32_t qy=-y;
+                bool a=(c0*qy-s0*x>=0);
+                bool b=(c1*qy-s1*x<=0);
+                if (span>180?!(a || b):!(a && b))
+                    continue;
+            }
+            plot(xc+x,yc+y,color);
+        }
+    }
+}
+
+// circles and ellipses from a point to large ones reaching off screen,
+// and arcs and pies starting and ending in every quadrant, crossing
+// quadrants, over half circle, and whole or empty
+static void ellipses()
+{
+    uint32_t shapes=0,bad=0;
+    clear();
+    for (uint16_t i=0;i<300;i++) {
+        int16_t x=between(-50,XPIXELS+50),y=between(-50,YPIXELS+50);
+        uint16_t rx=(i<20)?i/4:between(0,(i%4)?60:300);
+        uint16_t ry=(i%3)?rx:(uint16_t)between(0,(i%4)?60:300);
+        bool fill=i&1;
+        uint8_t color=1+xrandom()%255;
+        if (rx==ry) {
+            if (fill)
+                screen.filled_circle(x,y,rx,color);
+            else
+                screen.circle(x,y,rx,color);
+        }
+        else {
+            if (fill)
+                screen.filled_ellipse(x,y,rx,ry,color);
+            else
+                screen.ellipse(x,y,rx,ry,color);
+        }
+        ref_ellipse(x,y,rx,ry,fill,false,0,0,color);
+        shapes++;
+        bad+=compare();
+    }
+    report("circles and ellipses",shapes,bad);
+    shapes=bad=0;
+    clear();
+    for (int16_t start=-450;start<=450;start+=45) {
+        for (int16_t span=-390;span<=390;span+=65) {
+            for (uint8_t fill=0;fill<2;fill++) {
+                int16_t r=between(5,90);
+                int16_t x=between(-20,XPIXELS+20),y=between(-20,YPIXELS+20);
+                int16_t a=start+between(-20,20);
+                int16_t b=a+span;
+                uint8_t color=1+xrandom()%255;
+                if (fill)
+                    screen.pie(x,y,r,a,b,color);
+                else
+                    screen.arc(x,y,r,a,b,color);
+                ref_ellipse(x,y,r,r,fill,true,a,b,color);
+                shapes++;
+                uint32_t d=compare();
+                if (d)
+                    printf("  %s %d..%d r %d: %u pixels differ\n",
+                        fill?"pie":"arc",a,b,r,d);
+                bad+=d;
+            }
+        }
+    }
+    for (uint16_t i=0;i<400;i++) {
+        int16_t r=between(0,120);
+        int16_t x=between(-20,XPIXELS+20),y=between(-20,YPIXELS+20);
+        int16_t a=between(-720,720),b=between(-720,720);
+        bool fill=i&1;
+        uint8_t color=1+xrandom()%255;
+        if (fill)
+            screen.pie(x,y,r,a,b,color);
+        else
+            screen.arc(x,y,r,a,b,color);
+        ref_ellipse(x,y,r,r,fill,true,a,b,color);
+        shapes++;
+        bad+=compare();
+    }
+    report("arcs and pies",shapes,bad);
+}
+
+// screen and reference filled with random pixels
+static void pattern()
+{
+    uint8_t line[XPIXELS];
+    for (int16_t y=0;y<YPIXELS;y++) {
+        for (int16_t x=0;x<XPIXELS;x++)
+            line[x]=ref[y][x]=xrandom();
+        screen.draw_bitmap(0,y,XPIXELS,1,line,8);
+    }
+}
+
+// area x1,y1-x2,y2 copied to dx,dy in reference, as if through a buffer
+static void ref_copy(int16_t x1,int16_t y1,int16_t x2,int16_t y2,int16_t dx,int16_t dy)
+{
+    static uint8_t old[YPIXELS][XPIXELS];
+    memcpy(old,ref,sizeof(ref));
+    for (int16_t y=y1;y<=y2;y++) {
+        for (int16_t x=x1;x<=x2;x++)
+            ref[dy+y-y1][dx+x-x1]=old[y][x];
+    }
+}
+
+// copies and scrolls where source and destination overlap, forward and
+// backward, on the same lines and across lines. the areas are wider than
+// BLIT_BUFFER, so that the moves done in software go in several pieces
+static void moves()
+{
+    uint32_t shapes=0,bad=0;
+    pattern();
+    for (uint16_t i=0;i<200;i++) {
+        int16_t w=between(BLIT_BUFFER+1,XPIXELS);
+        int16_t h=between(1,(i&1)?YPIXELS:8);
+        int16_t x1=between(0,XPIXELS-w);
+        int16_t y1=between(0,YPIXELS-h);
+        int16_t dx=x1+between(-40,40);
+        int16_t dy=(i%3)?y1:y1+between(-20,20);
+        if (dx<0)
+            dx=0;
+        if (dx+w>XPIXELS)
+            dx=XPIXELS-w;
+        if (dy<0)
+            dy=0;
+        if (dy+h>YPIXELS)
+            dy=YPIXELS-h;
+        screen.queue_copy(x1,y1,x1+w-1,y1+h-1,dx,dy);
+        ref_copy(x1,y1,x1+w-1,y1+h-1,dx,dy);
+        shapes++;
+        uint32_t d=compare();
+        if (d)
+            printf("  %d,%d %dx%d to %d,%d: %u pixels differ\n",x1,y1,w,h,dx,dy,d);
+        bad+=d;
+    }
+    report("queue_copy overlapping",shapes,bad);
+    shapes=bad=0;
+    pattern();
+    screen.set_colors(15,0);
+    for (uint16_t i=0;i<40;i++) {
+        int16_t n=between(1,(i&1)?20:YPIXELS-1);
+        bool up=i&2;
+        if (up) {
+            screen.scroll_up(n);
+            ref_copy(0,n,XPIXELS-1,YPIXELS-1,0,0);
+            for (int16_t y=YPIXELS-n;y<YPIXELS;y++)
+                memset(ref[y],0,XPIXELS);
+        }
+        else {
+            screen.scroll_down(n);
+            ref_copy(0,0,XPIXELS-1,YPIXELS-1-n,0,n);
+            for (int16_t y=0;y<n;y++)
+                memset(ref[y],0,XPIXELS);
+        }
+        shapes++;
+        bad+=compare();
+        pattern();
+    }
+    report("scroll",shapes,bad);
+}
+
+// ways block mover of emulated chip fails, and what blitter_probe()
+// should find out of each
+static const struct {
+    const char *name;
+    uint8_t min_move_width;
+    bool single_line_moves,overlap_fails;
+    bool hw;
+    uint8_t minw,caps;
+} modes[]={
+    {"block mover works",0,false,false,true,1,BLIT_MULTILINE|BLIT_OVERLAP},
+    {"moves from 4 wide",4,false,false,true,4,BLIT_MULTILINE|BLIT_OVERLAP},
+    {"moves of one line",0,true,false,true,1,0},
+    {"no overlapping moves",0,false,true,true,1,BLIT_MULTILINE},
+    {"no block mover",9,false,false,false,1,BLIT_MULTILINE|BLIT_OVERLAP},
+};
+
+int main()
+{
+    for (uint8_t m=0;m<sizeof(modes)/sizeof(modes[0]);m++) {
+        screen.chip.min_move_width=modes[m].min_move_width;
+        screen.chip.single_line_moves=modes[m].single_line_moves;
+        screen.chip.overlap_fails=modes[m].overlap_fails;
+        screen.init();
+        printf("\n%-28s %6s %8s\n",modes[m].name,"shapes","differ");
+        report("blitter_probe",1,(screen.move_hw()!=modes[m].hw)+
+            (screen.move_min_width()!=modes[m].minw)+
+            (screen.move_caps()!=modes[m].caps));
+        // probe makes moves that fail on purpose
+        screen.chip.bad_moves=0;
+        polygons();
+        ellipses();
+        moves();
+        report("moves that went wrong",1,screen.chip.bad_moves);
+    }
+    return failed;
+}
@@ -0,0 +1,83 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2022 Madis Kaal <mast@nomad.ee>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+#include <stdio.h>
+#include <string.h>
+#include "hostscreen.hpp"
+
+// draws a test picture on emulated chip, prints transaction counts by
+// command and writes the visible picture into greymap file.
+// usage: emudemo [file.pgm]
+
+extern const FONT pal10_font;
+
+HostScreen screen;
+
+static const char *cmdname(uint8_t cmd)
+{
+    switch (cmd) {
+        case WRITE: return "WRITE";
+        case READ: return "READ";
+        case CURLINE: return "CURLINE";
+        case BLOCKMVC1: return "BLOCKMVC1";
+        case BLOCKMVC2: return "BLOCKMVC2";
+        case BLOCKMVST: return "BLOCKMVST";
+        case INDEXSTART: return "INDEXSTART";
+        case PROGRAM: return "PROGRAM";
+        default: return "other";
+    }
+}
+
+int main(int argc,char *argv[])
+{
+    screen.chip.logging=true;
+    screen.init();
+    screen.set_font(&pal10_font);
+    for (int16_t i=0;i<16;i++)
+        screen.filled_rect(i*20,0,i*20+19,39,i*16+15);
+    for (int16_t i=0;i<screen.width;i+=16)
+        screen.line(screen.width/2,screen.height/2,i,40,15);
+    screen.rect(10,150,309,229,15);
+    screen.set_pos(20,170);
+    screen.puts("Hello from emulated VS23S010");
+    screen.blit_flush();
+
+    uint32_t count[256],bytes[256];
+    memset(count,0,sizeof(count));
+    memset(bytes,0,sizeof(bytes));
+    for (size_t i=0;i<screen.chip.log.size();i++) {
+        count[screen.chip.log[i].cmd]++;
+        bytes[screen.chip.log[i].cmd]+=screen.chip.log[i].bytes;
+    }
+    printf("%-12s %10s %10s\n","command","selects","bytes");
+    for (uint16_t c=0;c<256;c++) {
+        if (count[c])
+            printf("%-12s %10u %10u (0x%02x)\n",cmdname(c),count[c],bytes[c],c);
+    }
+    printf("emulated time %.2f ms\n",screen.chip.now_ns/1e6);
+    if (argc>1 && !screen.chip.save_pgm(argv[1],screen.width,screen.height,STARTLINE)) {
+        perror(argv[1]);
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,63 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2022 Madis Kaal <mast@nomad.ee>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+#pragma once
+#include "vs23s010impl.hpp"
+#include "vs23emu.hpp"
+#include "spistats.hpp"
+
+// screen with emulated chip as transport. bytes go to the emulator one at
+// a time, the bulk transfers are the default ones of VS23S010T, so the
+// transaction log is what AVR build would send. all traffic is also
+// counted in stats
+//
+class HostScreen : public VS23S010T<HostScreen>
+{
+    friend class VS23S010T<HostScreen>;
+
+protected:
+
+    inline uint8_t spi_byte(uint8_t out)
+    {
+        stats.transfer(out);
+        return chip.transfer(out);
+    }
+
+    inline void spi_select(bool onoff)
+    {
+        stats.select(onoff);
+        chip.select(onoff);
+    }
+
+public:
+
+    VS23Emulator chip;
+    SPIStats stats;
+
+    // pixel of visible picture of shown page
+    uint8_t pixel(int16_t x,int16_t y) { return chip.pixel(x,y,STARTLINE); }
+    // what blitter_probe() found the block mover to do
+    bool move_hw() { return blithw; }
+    uint8_t move_min_width() { return blitminw; }
+    uint8_t move_caps() { return blitcaps; }
+};
@@ -0,0 +1,4 @@
+// delays for host build, nothing waits for the emulated chip
+#pragma once
+static inline void _delay_ms(double) {}
+static inline void _delay_us(double) {}
@@ -0,0 +1,273 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2022 Madis Kaal <mast@nomad.ee>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+#include <string.h>
+#include "vs23emu.hpp"
+#include "vs23s010.hpp"
+
+VS23Emulator::VS23Emulator() : logging(false), min_move_width(0),
+    single_line_moves(false), overlap_fails(false), bad_moves(0),
+    spi_ns_per_byte(868), // 8 clocks at 9.216MHz, F_CPU/2
+    blit_ns_per_byte(100)
+{
+    reset();
+}
+
+void VS23Emulator::reset()
+{
+    // memory content is random after power up
+    uint32_t x=734518;
+    for (uint32_t i=0;i<MEMSIZE;i++) {
+        x^=x<<13;
+        x^=x>>17;
+        x^=x<<5;
+        vram[i]=x;
+    }
+    log.clear();
+    status=multiic=0;
+    picstart=picend=linelen=indexstart=vdctrl1=vdctrl2=0;
+    program=0;
+    mvsrc=mvdst=mvskip=0;
+    mvflags=mvwidth=mvheight=0;
+    now_ns=move_end_ns=0;
+    selected=false;
+    cmd=0;
+    count=0;
+    addr=0;
+}
+
+void VS23Emulator::select(bool onoff)
+{
+    if (onoff && !selected) {
+        count=0;
+        addr=0;
+    }
+    if (!onoff && selected) {
+        register_write();
+        if (logging && count) {
+            Transaction t={cmd,addr,count};
+            if (cmd==WRITE || cmd==READ)
+                t.addr=(((uint32_t)shift[0]<<16)|((uint32_t)shift[1]<<8)|shift[2])&(MEMSIZE-1);
+            log.push_back(t);
+        }
+    }
+    selected=onoff;
+}
+
+uint16_t VS23Emulator::curline()
+{
+    uint16_t line=(now_ns/(uint64_t)(LINE_LENGTH_US*1000))%TOTAL_LINES;
+    return line|(move_active()?CURLINE_MVBS:0);
+}
+
+uint8_t VS23Emulator::transfer(uint8_t out)
+{
+    uint8_t in=0;
+    now_ns+=spi_ns_per_byte;
+    if (!selected)
+        return 0xff;
+    if (!count) {
+        cmd=out;
+        count++;
+        if (cmd==BLOCKMVST)
+            block_move();
+        return 0;
+    }
+    switch (cmd) {
+        case WRITE:
+        case READ:
+            if (count<4) {
+                shift[count-1]=out;
+                addr=((addr<<8)|out)&(MEMSIZE-1);
+                break;
+            }
+            // without sequential mode only one byte is accessed
+            if (count>4 && !(status&0x40))
+                break;
+            if (cmd==WRITE)
+                vram[addr]=out;
+            else
+                in=vram[addr];
+            addr=(addr+1)&(MEMSIZE-1);
+            break;
+        case CURLINE:
+            if (count==1)
+                in=curline()>>8;
+            else if (count==2)
+                in=curline()&0xff;
+            break;
+        case READ_STATUS:
+            in=status;
+            break;
+        case READ_MULTIIC:
+            in=multiic;
+            break;
+        case READ_ID:
+            in=(count&1)?0x2b:0x00;
+            break;
+        default:
+            if (count<=sizeof(shift))
+                shift[count-1]=out;
+            break;
+    }
+    count++;
+    return in;
+}
+
+// register writes take effect when the chip is deselected
+void VS23Emulator::register_write()
+{
+    uint16_t w=((uint16_t)shift[0]<<8)|shift[1];
+    switch (cmd) {
+        case WRITE_STATUS:
+            if (count>1) status=shift[0];
+            break;
+        case WRITE_MULTIIC:
+            if (count>1) multiic=shift[0];
+            break;
+        case PICSTART:
+            if (count>2) picstart=w;
+            break;
+        case PICEND:
+            if (count>2) picend=w;
+            break;
+        case LINELEN:
+            if (count>2) linelen=w;
+            break;
+        case VDCTRL1:
+            if (count>2) vdctrl1=w;
+            break;
+        case VDCTRL2:
+            if (count>2) vdctrl2=w;
+            break;
+        case INDEXSTART:
+            if (count>2) indexstart=w;
+            break;
+        case PROGRAM:
+            if (count>4)
+                program=((uint32_t)w<<16)|((uint16_t)shift[2]<<8)|shift[3];
+            break;
+        case BLOCKMVC1:
+            if (count>5) {
+                mvsrc=w;
+                mvdst=((uint16_t)shift[2]<<8)|shift[3];
+                mvflags=shift[4];
+            }
+            break;
+        case BLOCKMVC2:
+            if (count>4) {
+                mvskip=w;
+                mvwidth=shift[2];
+                mvheight=shift[3];
+            }
+            break;
+    }
+}
+
+// the move is carried out right away but the mover is reported busy
+// for the time it would take on the chip
+void VS23Emulator::block_move()
+{
+    uint32_t src=((uint32_t)mvsrc<<1)|((mvflags>>2)&1);
+    uint32_t dst=((uint32_t)mvdst<<1)|((mvflags>>1)&1);
+    bool backwards=mvflags&1;
+    // bytes in the order the mover takes them
+    std::vector<uint32_t> from,to;
+    for (uint16_t row=0;row<=mvheight;row++) {
+        for (uint16_t i=0;i<mvwidth;i++) {
+            from.push_back(src&(MEMSIZE-1));
+            to.push_back(dst&(MEMSIZE-1));
+            if (backwards) {
+                src--;
+                dst--;
+            }
+            else {
+                src++;
+                dst++;
+            }
+        }
+        if (backwards) {
+            src-=mvskip;
+            dst-=mvskip;
+        }
+        else {
+            src+=mvskip;
+            dst+=mvskip;
+        }
+    }
+    bool narrow=(mvwidth>1 && mvwidth<min_move_width);
+    bool lines=(mvheight && single_line_moves);
+    bool overlap=false;
+    if (overlap_fails) {
+        std::vector<bool> read(MEMSIZE);
+        for (size_t i=0;i<from.size();i++)
+            read[from[i]]=true;
+        for (size_t i=0;i<to.size() && !overlap;i++)
+            overlap=read[to[i]];
+    }
+    if (narrow || lines || overlap)
+        bad_moves++;
+    size_t n=from.size();
+    for (size_t k=0;k<n;k++) {
+        size_t i=overlap?n-1-k:k;
+        if (narrow && i%mvwidth)
+            continue;
+        if (lines && i>=mvwidth)
+            continue;
+        vram[to[i]]=vram[from[i]];
+    }
+    if (move_end_ns<now_ns)
+        move_end_ns=now_ns;
+    move_end_ns+=(uint64_t)mvwidth*(mvheight+1)*blit_ns_per_byte;
+}
+
+uint32_t VS23Emulator::line_source(uint16_t line)
+{
+    uint32_t ia=((uint32_t)indexstart*4+line*3)&(MEMSIZE-1);
+    return ((uint32_t)vram[ia+2]<<9)|((uint32_t)vram[ia+1]<<1)|(vram[ia]>>7);
+}
+
+uint8_t VS23Emulator::proto_of(uint16_t line)
+{
+    return vram[((uint32_t)indexstart*4+line*3)&(MEMSIZE-1)]&0xf;
+}
+
+uint8_t VS23Emulator::pixel(int16_t x,int16_t y,uint16_t firstline)
+{
+    return vram[(line_source(firstline+y)+x)&(MEMSIZE-1)];
+}
+
+bool VS23Emulator::save_pgm(const char *name,int16_t w,int16_t h,uint16_t firstline)
+{
+    FILE *f=fopen(name,"wb");
+    if (!f)
+        return false;
+    fprintf(f,"P5\n%d %d\n255\n",w,h);
+    for (int16_t y=0;y<h;y++) {
+        for (int16_t x=0;x<w;x++) {
+            fputc(pixel(x,y,firstline),f);
+        }
+    }
+    fclose(f);
+    return true;
+}
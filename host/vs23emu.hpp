@@ -0,0 +1,111 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2022 Madis Kaal <mast@nomad.ee>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+#pragma once
+#include <stdint.h>
+#include <stdio.h>
+#include <vector>
+
+// software model of VS23S010 as seen over SPI, for running the driver
+// on a PC. it keeps the 128KB of video memory and the registers the
+// driver uses, executes block moves and records every transaction so
+// that the cost of drawing operations can be looked at without a board.
+//
+// time is emulated, every byte on SPI advances it by spi_ns_per_byte
+// and block moves keep CURLINE_MVBS set for blit_ns_per_byte for every
+// byte they move. current scanline in CURLINE is derived from the same
+// clock.
+//
+class VS23Emulator
+{
+public:
+
+    static const uint32_t MEMSIZE=131072;
+
+    // one chip select period
+    struct Transaction {
+        uint8_t cmd;        // first byte after select
+        uint32_t addr;      // memory address for READ and WRITE
+        uint32_t bytes;     // total number of bytes including command
+    };
+
+    uint8_t vram[MEMSIZE];
+    std::vector<Transaction> log;
+    bool logging;
+
+    // registers
+    uint8_t status;
+    uint8_t multiic;
+    uint16_t picstart,picend,linelen,indexstart,vdctrl1,vdctrl2;
+    uint32_t program;
+    // block mover parameters, as written and as latched at start
+    uint16_t mvsrc,mvdst,mvskip;
+    uint8_t mvflags,mvwidth,mvheight;
+
+    // ways block mover of some chips fails. moves narrower than
+    // min_move_width only copy first byte of every line, 0 for mover that
+    // always works. with single_line_moves only the first line of a move
+    // is copied, and with overlap_fails moves where source and
+    // destination overlap go from the wrong end. moves that came out
+    // wrong this way are counted in bad_moves
+    uint8_t min_move_width;
+    bool single_line_moves;
+    bool overlap_fails;
+    uint32_t bad_moves;
+
+    // timing model
+    uint32_t spi_ns_per_byte;
+    uint32_t blit_ns_per_byte;
+    uint64_t now_ns;
+    uint64_t move_end_ns;
+
+    VS23Emulator();
+
+    void reset();
+    void select(bool onoff);
+    uint8_t transfer(uint8_t out);
+
+    // current scanline and block mover state, as CURLINE reports them
+    uint16_t curline();
+    bool move_active() { return now_ns<move_end_ns; }
+
+    // address of picture data for given line of the frame, decoded from
+    // the line index table the same way the video controller does it
+    uint32_t line_source(uint16_t line);
+    uint8_t proto_of(uint16_t line);
+    // pixel of visible picture, y is counted from first picture line
+    uint8_t pixel(int16_t x,int16_t y,uint16_t firstline);
+    // write visible picture area as binary greymap
+    bool save_pgm(const char *name,int16_t w,int16_t h,uint16_t firstline);
+
+private:
+
+    bool selected;
+    uint8_t cmd;
+    uint32_t count;
+    uint32_t addr;
+    uint8_t shift[6];
+
+    void block_move();
+    void register_write();
+};
@@ -0,0 +1,66 @@
+#include "font.h"
+
+extern const FONT pal10_font;
+
+uint8_t const pal10_atlas_lines[] PROGMEM = {
+  0x01,0x00,0x10,0xff,0x28,0x04,0x10,0x42,0x38,0x18,0x08,0xff,0x10,0xfd,0x00,0x08,
+  0x02,0x38,0x08,0x78,0x7c,0x22,0x7e,0x3c,0xfe,0xff,0x7c,0xfc,0x00,0x05,0x3c,0x7c,
+  0x38,0xfc,0x3e,0xf8,0xff,0xfe,0x02,0x3c,0x00,0x10,0xff,0x28,0x03,0x3c,0xa6,0x44,
+  0x08,0xff,0x18,0x01,0x54,0x10,0xfe,0x00,0x08,0x06,0x44,0x18,0xcc,0xc6,0x62,0x40,
+  0x60,0x02,0xff,0xc6,0xff,0x00,0x08,0x04,0x00,0x20,0x66,0xc2,0x6c,0x86,0x60,0x8c,
+  0xff,0x80,0x0c,0x66,0x00,0x10,0x28,0xfe,0x50,0x4c,0x44,0x08,0x30,0x0c,0x38,0x10,
+  0xfe,0x00,0x0a,0x0c,0xce,0x38,0x04,0x06,0x42,0x40,0x80,0x04,0xc6,0x82,0xff,0x18,
+  0x08,0x0c,0x00,0x30,0x46,0x9a,0xc6,0x86,0xc0,0x86,0xff,0x80,0x0a,0xc0,0x00,0x10,
+  0x00,0x28,0x3c,0x18,0x38,0x00,0x20,0x04,0xff,0x7c,0x0d,0x00,0x7c,0x00,0x18,0x9a,
+  0x28,0x0c,0x3c,0x7e,0x7c,0xfc,0x0c,0x7c,0x7e,0xfe,0x18,0x07,0x7c,0x18,0x0c,0xaa,
+  0x82,0xfc,0x80,0x82,0xff,0xf8,0x0c,0x80,0x00,0x10,0x00,0x28,0x12,0x30,0x68,0x00,
+  0x20,0x04,0x38,0x10,0xfe,0x00,0x0a,0x30,0xb2,0x08,0x38,0x06,0x02,0x06,0x86,0x08,
+  0xc6,0x02,0xff,0x00,0x08,0x30,0x00,0x0c,0x18,0x9e,0xfe,0x86,0x80,0x82,0xff,0x80,
+  0x00,0x8e,0xfe,0x00,0x09,0xfe,0x12,0x64,0x86,0x00,0x30,0x0c,0x54,0x10,0x18,0xff,
+  0x00,0x03,0x60,0xe6,0x08,0x60,0xfe,0x02,0x03,0x82,0x18,0x82,0x02,0xfe,0x18,0x03,
+  0x7c,0x18,0x00,0xcc,0xff,0x82,0x01,0xc0,0x86,0xff,0x80,0x08,0xc2,0x00,0x10,0x00,
+  0x28,0x7c,0xca,0x84,0x00,0xff,0x18,0x1a,0x10,0x00,0x10,0x00,0x18,0xc0,0x44,0x08,
+  0xc0,0xc6,0x02,0x46,0xc6,0x10,0xc6,0x06,0x18,0x08,0x0c,0x00,0x30,0x18,0x60,0x82,
+  0x86,0x60,0x8c,0xff,0x80,0x0a,0x66,0x00,0x10,0x00,0x28,0x10,0x84,0x7a,0x00,0x08,
+  0x10,0xff,0x00,0x08,0x10,0x00,0x18,0x80,0x38,0x08,0xfe,0x7c,0x02,0xff,0x7c,0x00,
+  0x30,0xff,0x7c,0x0d,0x00,0x08,0x04,0x00,0x20,0x18,0x3c,0x82,0xfc,0x3e,0xf8,0xfe,
+  0x80,0x3c,0xe6,0x00,0x00,0x08,0xcd,0x00,0x0c,0x82,0x10,0x04,0x86,0x80,0xc6,0x82,
+  0x38,0xfc,0x38,0xfc,0x7c,0xfe,0xfc,0x82,0x12,0xfe,0x3c,0x80,0x3c,0x10,0x00,0x30,
+  0x00,0x80,0x00,0x02,0x00,0x1c,0x00,0x80,0x10,0x08,0x80,0x10,0xfe,0x00,0x20,0x82,
+  0x10,0x04,0x8c,0x80,0xee,0xc2,0x44,0x86,0x44,0x86,0xc6,0x10,0x82,0xc6,0x82,0xc6,
+  0x82,0x06,0x20,0xc0,0x04,0x38,0x00,0x10,0x00,0x80,0x00,0x02,0x00,0x30,0x00,0x80,
+  0xff,0x00,0x01,0x80,0x10,0xfe,0x00,0x1a,0x82,0x10,0x04,0x98,0x80,0xba,0xe2,0xc6,
+  0x86,0xc6,0x86,0xc0,0x10,0x82,0x44,0x92,0x6c,0xc6,0x0c,0x20,0x60,0x04,0x6c,0x00,
+  0x10,0x7e,0xfc,0xff,0x7e,0x20,0x7c,0x20,0x7e,0xfc,0x10,0x08,0x8e,0x10,0xec,0xfc,
+  0x7c,0xfe,0x10,0x04,0xf0,0x80,0xba,0xb2,0x82,0xfc,0x82,0xfc,0x7c,0x10,0x82,0x44,
+  0x92,0x38,0x7c,0x18,0x20,0x30,0x04,0xff,0x00,0x03,0x10,0xc2,0x86,0xc0,0xff,0xc2,
+  0x1f,0x38,0xc2,0x86,0x10,0x08,0x98,0x10,0xb6,0x86,0xc6,0x82,0x10,0x04,0x98,0x80,
+  0x92,0x9a,0x82,0x80,0x82,0x98,0x06,0x10,0x82,0x6c,0x92,0x38,0x10,0x30,0x20,0x18,
+  0x04,0xfe,0x00,0xff,0x82,0x03,0x80,0x82,0xfe,0x20,0xff,0x82,0x04,0x10,0x08,0xf0,
+  0x10,0x92,0xfe,0x82,0x14,0x10,0x0c,0x8c,0x80,0x82,0x8e,0xc6,0x80,0xcc,0x8c,0x02,
+  0x10,0x82,0x28,0x92,0x6c,0x10,0x60,0x20,0x0c,0x04,0xfe,0x00,0xff,0x82,0x0a,0x80,
+  0x82,0x80,0x20,0xc2,0x82,0x10,0x08,0x98,0x10,0x92,0xfe,0x82,0x14,0x10,0x18,0x86,
+  0x80,0x82,0x86,0x44,0x80,0x46,0x86,0xc6,0x10,0xc6,0x38,0xd6,0xc6,0x10,0xc0,0x20,
+  0x06,0x04,0xfe,0x00,0x13,0xce,0x86,0xc0,0xc2,0xc0,0x20,0x7e,0x82,0x18,0x08,0x8c,
+  0x18,0x92,0x82,0xc6,0x82,0x10,0x30,0x82,0xfe,0xff,0x82,0x13,0x38,0x80,0x3a,0x82,
+  0x7c,0x10,0x7c,0x10,0x6c,0x82,0x10,0xfe,0x3c,0x02,0x3c,0x00,0xfe,0x00,0x7a,0xfc,
+  0xfe,0x7e,0x06,0x20,0x02,0x82,0x0c,0x18,0x86,0x0c,0xff,0x82,0x00,0x7c,0xe2,0x00,
+  0x00,0x06,0xff,0x00,0x00,0x30,0xdd,0x00,0x00,0x7c,0xff,0x00,0x00,0x60,0xf8,0x00,
+  0x00,0x20,0xda,0x00,0x00,0x20,0xfb,0x00,0x03,0x0c,0x10,0x30,0x32,0xe8,0x00,0x04,
+  0xfc,0x7e,0x5e,0x7e,0x7c,0xfe,0x82,0x07,0xc6,0x82,0xfe,0x18,0x10,0x18,0x6a,0x10,
+  0xe9,0x00,0x04,0x86,0xc2,0x70,0x80,0x20,0xfe,0x82,0x02,0x6c,0x82,0x06,0xff,0x10,
+  0x02,0x08,0x44,0x30,0xe9,0x00,0xff,0x82,0x0d,0x40,0x7c,0x20,0x82,0xc6,0x92,0x38,
+  0x82,0x1c,0x30,0x00,0x0c,0x00,0x7e,0xe9,0x00,0xff,0x82,0x0d,0x40,0x02,0x20,0x82,
+  0x6c,0xd6,0x38,0x7e,0x70,0x30,0x10,0x0c,0x00,0x7e,0xe9,0x00,0x0a,0x86,0xc2,0x40,
+  0x06,0x30,0xc6,0x38,0x7c,0x6c,0x02,0xc0,0xff,0x10,0x02,0x08,0x00,0x30,0xe9,0x00,
+  0x0f,0xfc,0x7e,0x40,0xfc,0x1c,0x7c,0x10,0x54,0xc6,0x06,0xfe,0x18,0x10,0x18,0x00,
+  0x10,0xe9,0x00,0x01,0x80,0x02,0xfa,0x00,0x04,0x0c,0x00,0x0c,0x10,0x30,0xe7,0x00,
+  0x01,0x80,0x02,0xfa,0x00,0x00,0x38,0xe3,0x00,
+};
+
+const FONTATLAS pal10_atlas = {
+ &pal10_font,
+ 8,40,
+ 3,1,
+ pal10_atlas_lines
+};
@@ -0,0 +1,94 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2022 Madis Kaal <mast@nomad.ee>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+#pragma once
+#include <stdint.h>
+#include "vs23s010.hpp"
+
+// SPI traffic counters. a transport can call select() and transfer() from
+// its spi_select() and spi_byte() (and count() from bulk transfers) to
+// find out what drawing operations cost on the wire. the first byte after
+// chip select is taken as command, CURLINE reads are counted as polls as
+// that is how block mover busy state and current line are waited for.
+//
+class SPIStats
+{
+    bool first;
+
+public:
+
+    uint32_t selects;   // chip select assertions
+    uint32_t commands;  // command bytes
+    uint32_t payload;   // address and data bytes
+    uint32_t polls;     // CURLINE reads
+    uint32_t blits;     // block mover starts
+
+    SPIStats() { clear(); }
+
+    void clear()
+    {
+        first=false;
+        selects=commands=payload=polls=blits=0;
+    }
+
+    inline void select(bool onoff)
+    {
+        if (onoff) {
+            selects++;
+            first=true;
+        }
+    }
+
+    // count bytes sent in one go, first one is the one given
+    inline void count(uint8_t out,uint16_t bytes)
+    {
+        if (!bytes)
+            return;
+        if (first) {
+            first=false;
+            commands++;
+            if (out==CURLINE)
+                polls++;
+            else if (out==BLOCKMVST)
+                blits++;
+            bytes--;
+        }
+        payload+=bytes;
+    }
+
+    inline void transfer(uint8_t out) { count(out,1); }
+
+    // total number of bytes on the wire
+    uint32_t bytes() const { return commands+payload; }
+
+    SPIStats operator-(const SPIStats &s) const
+    {
+        SPIStats d;
+        d.selects=selects-s.selects;
+        d.commands=commands-s.commands;
+        d.payload=payload-s.payload;
+        d.polls=polls-s.polls;
+        d.blits=blits-s.blits;
+        return d;
+    }
+};
@@ -95,7 +95,9 @@ SOFTWARE.
 
 
 #ifdef PAL_VIDEO
+    #ifndef YPIXELS
     #define YPIXELS 240
+    #endif
     #define XPIXELS 320
     #define TOTAL_LINES 313
     #define VSYNCLINES 8
@@ -126,7 +128,11 @@ SOFTWARE.
     #define PLLCLKS_PER_PIXEL 5    // Width, in PLL clocks, of each pixel
     // On which line the picture area begins, the Y direction.
 
+    #ifdef PICLINE_POW2
+    #define BEXTRA (512-PICLINE_LENGTH_BYTES) // pad lines to 512 bytes
+    #else
     #define BEXTRA 3 // if pic-to-proto border atrifacts occur, try 8
+    #endif
     #define PROTOLINES 4  // lines are used for sync timing, porch and border area
 
     #define BLANK_LEVEL 0x5b //0x005b // 43 IRE
@@ -154,7 +160,9 @@ SOFTWARE.
 
 // NTSC is completely untested for now
 
+    #ifndef YPIXELS
     #define YPIXELS 200
+    #endif
     #define XPIXELS 320
     #define VSYNCLINES 10
     #define XTAL_MHZ 3.579545 // Crystal frequency in MHZ
@@ -173,7 +181,11 @@ SOFTWARE.
     #define PLLCLKS_PER_PIXEL 5    // Width, in PLL clocks, of each pixel
     // On which line the picture area begins, the Y direction.
 
+    #ifdef PICLINE_POW2
+    #define BEXTRA (512-PICLINE_LENGTH_BYTES) // pad lines to 512 bytes
+    #else
     #define BEXTRA 0  // try 8 if pic-to-proto border artifacts occur
+    #endif
     #define PROTOLINES 3  // lines are used for sync timing, porch and border area
 
     // These are for proto lines and so format is VVVVUUUUYYYYYYYY 
@@ -227,6 +239,11 @@ SOFTWARE.
 #define INDEX_START_LONGWORDS ((PROTO_AREA_WORDS+1)/2)
 #define INDEX_START_WORDS (INDEX_START_LONGWORDS * 2)
 #define INDEX_START_BYTES (INDEX_START_WORDS * 2)
+// with more than one page every page has its own line index table,
+// these follow each other aligned to longwords as INDEXSTART needs
+#define INDEX_TABLE_BYTES (((TOTAL_LINES*3)+3)&~3)
+#define INDEX_TABLE_BYTE_ADDRESS(p) (INDEX_START_BYTES+INDEX_TABLE_BYTES*(p))
+#define INDEX_TABLE_LONGWORDS(p) (INDEX_START_LONGWORDS+(INDEX_TABLE_BYTES/4)*(p))
 
 #define PIXEL_TIME (1.0/PLL_MHZ*PLLCLKS_PER_PIXEL)
 #define VISIBLE_TIME (FRPORCH_US-BLANK_END_US)
@@ -250,12 +267,42 @@ SOFTWARE.
 #define PICLINE_LENGTH_BYTES ((uint16_t)(PICX*PICBITS/8+0.5+1))
 
 // Picture area memory start point
-#define PICLINE_START ((INDEX_START_BYTES + TOTAL_LINES*3+1)+1)
+#define PICLINE_START ((INDEX_START_BYTES + INDEX_TABLE_BYTES*(PAGES-1) + TOTAL_LINES*3+1)+1)
 
 // Picture area line start addresses
 #define PICLINE_WORD_ADDRESS(n) (PICLINE_START/2+(PICLINE_LENGTH_BYTES/2+BEXTRA/2)*(n))
 #define PICLINE_BYTE_ADDRESS(n) ((uint32_t)(PICLINE_START+((uint32_t)(PICLINE_LENGTH_BYTES)+BEXTRA)*(n)))
 #define PICLINE_TOTAL_BYTES ((uint32_t)PICLINE_LENGTH_BYTES+BEXTRA)
+// pages are stored one after another, each YPIXELS lines, the memory
+// after the last one is not visible
+#define PAGE_BYTE_ADDRESS(p) PICLINE_BYTE_ADDRESS((uint32_t)YPIXELS*(p))
+#define OFFSCREEN_BYTE_ADDRESS PAGE_BYTE_ADDRESS(PAGES)
+#define VRAM_BYTES 131072UL
+// video memory that is not shown is handed out in bands of lines with
+// the same line stride as picture, so that block mover can copy between
+// them and screen. normally this is right after the last page. with
+// padded lines the padding at the end of first page lines is used
+// instead, as there is not much memory left after the pages. its first
+// 8 bytes are left alone, these keep pic-to-proto border artifacts
+// away. before the picture there is no room for even one line
+#ifdef PICLINE_POW2
+#define BITMAP_GUARD 8
+#define BITMAP_BYTE_ADDRESS (PICLINE_START+PICLINE_LENGTH_BYTES+BITMAP_GUARD)
+#define BITMAP_WIDTH (BEXTRA-BITMAP_GUARD)
+#define BITMAP_LINES (YPIXELS)
+#else
+#define BITMAP_BYTE_ADDRESS OFFSCREEN_BYTE_ADDRESS
+#define BITMAP_WIDTH (XPIXELS)
+#define BITMAP_LINES ((VRAM_BYTES-BITMAP_BYTE_ADDRESS)/PICLINE_TOTAL_BYTES)
+#endif
+// sprite images and the screen saved under them are side by side in a
+// band of lines
+#define SPRITE_CELLS (BITMAP_WIDTH/(2*SPRITE_SIZE))
+#define SPRITE_LINES (((SPRITES+SPRITE_CELLS-1)/SPRITE_CELLS)*SPRITE_SIZE)
+#define TILE_DIRTY 0x80
+// block mover capabilities found at init
+#define BLIT_MULTILINE 0x01 // moves of several lines
+#define BLIT_OVERLAP 0x02   // moves between overlapping areas
 #define VDCTRL2_LINECOUNT   ((TOTAL_LINES-1)<<0)
 #define VDCTRL2_PROGRAM_LENGTH ((PLLCLKS_PER_PIXEL-1)<<10)
 
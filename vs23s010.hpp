@@ -28,38 +28,303 @@ SOFTWARE.
 #define noNTSC_VIDEO   // 320x200 noninterclaced NTSC
 #define PAL_VIDEO    // 320x240 noninterlaced PAL
 
+// number of pictures in video memory for page flipping. a 320x240 picture
+// takes 77760 bytes, so more than one only fits with YPIXELS reduced, for
+// example to 160 for two pages or to 120 for three
+#ifndef PAGES
+#define PAGES 1
+#endif
+
+// number of fonts that can be kept in video memory at the same time,
+// the same font with different colors takes a slot of its own
+#ifndef FONTSLOTS
+#define FONTSLOTS 3
+#endif
+
+// number of sprites and their largest width and height. each sprite has
+// room for its image and for the screen under it in video memory. the
+// band of lines for all of them is allocated on first use, if it does
+// not fit then sprites are not drawn
+#ifndef SPRITES
+#define SPRITES 4
+#endif
+#ifndef SPRITE_SIZE
+#define SPRITE_SIZE 32
+#endif
+
+// lines of video memory for tile images. these are allocated when tile
+// map is set up, if they do not fit then tiles are not drawn
+#ifndef TILE_LINES
+#define TILE_LINES 32
+#endif
+
+// largest number of points in filled polygon
+#ifndef POLYGON_EDGES
+#define POLYGON_EDGES 16
+#endif
+
+// number of lines from which columns narrower than 8 pixels are filled
+// by copying with block mover
+#ifndef BLIT_MIN_LINES
+#define BLIT_MIN_LINES 8
+#endif
+
+// bytes of RAM buffer for moves done in software
+#ifndef BLIT_BUFFER
+#define BLIT_BUFFER 32
+#endif
+
+// number of free bands of video memory that can be kept track of
+#ifndef VMEM_FREE
+#define VMEM_FREE 8
+#endif
+
+// number of block moves that can be queued, power of 2
+#ifndef BLITQUEUE
+#define BLITQUEUE 8
+#endif
+
 #include "vs23defines.hpp"
 
-class VS23S010
+static_assert(OFFSCREEN_BYTE_ADDRESS<=VRAM_BYTES,"pages do not fit in video memory");
+static_assert(SPRITES>0 && SPRITE_CELLS>0 && SPRITE_SIZE<=255,"bad sprite size");
+
+// the driver is bound to its SPI transport at compile time, T is the
+// class derived from this that implements the transport methods
+//
+//   uint8_t spi_byte(uint8_t out);
+//   void spi_select(bool onoff);
+//
+// and optionally the bulk transfers spi_write(), spi_fill() and spi_read()
+// that otherwise default to looping over spi_byte(). T needs to declare
+// VS23S010T<T> a friend if these are not public. with transport methods
+// inline the compiler can fold them into innermost loops of the drawing
+// primitives. for run-time binding use VS23S010 class below instead.
+//
+template <class T>
+class VS23S010T
 {
 
 private:
 
-    void setlindex(uint16_t line, uint16_t addr);
-    void setplindex(uint16_t line, uint32_t byteaddr, uint16_t protoaddr);
+    static uint8_t sync_protoline(uint16_t line);
+    void set_index_table();
     void protoline(uint16_t line, uint16_t offset, uint16_t limit, uint16_t data);
+    void set_picture_indexes();
 
 protected:
 
-    // address of character bitmaps of current font loaded into vram with appropriate line
-    // spacing and address of character info (offset from vmemchars and char width)
+    // address of character bitmaps of current font loaded into vram with
+    // appropriate line spacing
     uint32_t vmemchars;
-    uint32_t vcharinfo;
+    // free bands of video memory past the picture, in order of address
+    struct vband_t {
+        uint16_t line;
+        uint16_t lines;
+    };
+    vband_t vfree[VMEM_FREE];
+    uint8_t vfreecount;
+    // fonts in the colors they are used with, loaded into video memory.
+    // each one has its own band of lines, where glyphs are in cells as
+    // wide as the widest character of the font
+    struct fontslot_t {
+        const FONT *font;   // NULL for unused slot
+        uint8_t fg,bg;      // colors the glyphs are rendered with
+        uint16_t line;      // first line in bitmap area
+        uint16_t lines;     // number of lines used
+        uint16_t used;      // fontclock when last selected
+        uint8_t cellw;      // width of glyph cell
+        uint8_t cells;      // number of cells on a row
+        uint8_t rendered[32]; // bit for every glyph already rendered
+    };
+    fontslot_t fontslots[FONTSLOTS];
+    uint8_t fontslot;       // slot last used
+    uint16_t fontclock;
+    uint8_t font_slot();
+    uint8_t font_find();
+    uint8_t font_lru(bool loaded);
+    void font_free(uint8_t s);
+    uint8_t load_font();
+    void render_glyph(uint8_t c,uint8_t w,uint32_t addr);
+    uint32_t glyph_address(const fontslot_t *f,uint8_t c);
+    const char* text_run(const char *s);
+    // sprites, the area of screen under each one is saved when it is
+    // drawn and put back before it moves. images and saved screens are in
+    // band of lines that is allocated when the first image is set
+    int16_t spriteband;
+    uint32_t sprite_address(uint8_t s);
+    struct sprite_t {
+        uint8_t w,h;        // size, 0 for sprite without image
+        bool shown;
+        int16_t x,y;        // position
+        int16_t sx,sy;      // part of screen saved, sprite can be clipped
+        uint8_t sw,sh;
+    };
+    sprite_t sprites[SPRITES];
+    // tile map layer, map has a byte for every cell with the number of
+    // tile there, and TILE_DIRTY set if the cell needs drawing
+    uint8_t *tilemap;
+    int16_t tileband;
+    uint8_t tilecols,tilerows;
+    uint8_t tilew,tileh;
+    uint8_t tilecells;      // tiles on a row in video memory
+    int16_t tilex,tiley;
+    uint32_t tile_address(uint8_t t);
+    void offscreen_copy(uint32_t area,int16_t x,int16_t y,uint8_t w,uint8_t h,bool save);
+    // curves are drawn as horizontal spans, arcs and pies limited to
+    // sector between start and end directions, wide when over half circle
+    struct sector_t {
+        int16_t c0,s0,c1,s1;
+        bool wide;
+    };
+    void sector_dir(int16_t angle,int16_t &c,int16_t &s);
+    static void half_plane(int16_t c,int16_t s,int16_t qy,int16_t &x1,int16_t &x2);
+    void sector_span(int16_t xc,int16_t y,int16_t x1,int16_t x2,int16_t qy,uint8_t color,const sector_t *sector);
+    void ellipse_spans(int16_t xc,int16_t yc,uint16_t rx,uint16_t ry,bool fill,uint8_t color,const sector_t *sector);
+    void sector(int16_t x,int16_t y,uint16_t r,int16_t start,int16_t end,bool fill,uint8_t color);
+    // images for draw_bitmap() can be in RAM or in flash
+    inline uint8_t bits_byte(const uint8_t *p,bool flash)
+    {
+        return flash?pgm_read_byte(p):*p;
+    }
+    void draw_bits(int16_t x,int16_t y,uint16_t w,uint16_t h,const uint8_t *bits,uint8_t bpp,const uint8_t *palette,bool flash);
+    // page that drawing goes to, its first picture line address, and
+    // page that is currently displayed
+    uint8_t drawpage,showpage;
+    uint32_t drawbase;
+    // picture line of each page that is shown on top of the screen. when
+    // scrolling by rewriting line indexes, the picture lines are used as
+    // ring buffer and screen line y is in picture line (topline+y)%height
+    int16_t topline[PAGES];
+    bool ringscroll;
+
+    // byte address of screen line y, and addresses of lines following
+    // and preceding the line at given address
+    // with lines padded to power of two the address is a shift. otherwise
+    // it is stepped from last one when possible, as multiplying is slow
+    // on AVR. the last address must be forgotten when topline or draw
+    // page changes
+#ifndef PICLINE_POW2
+    int16_t lasty;
+    uint32_t lastaddr;
+#endif
+    inline uint32_t line_address(int16_t y)
+    {
+#ifndef PICLINE_POW2
+        if (y==lasty)
+            return lastaddr;
+        if (y==lasty+1) {
+            lasty=y;
+            return lastaddr=next_line(lastaddr);
+        }
+        if (y==lasty-1) {
+            lasty=y;
+            return lastaddr=prev_line(lastaddr);
+        }
+        lasty=y;
+#endif
+        y+=topline[drawpage];
+        if (y>=height)
+            y-=height;
+#ifndef PICLINE_POW2
+        return lastaddr=drawbase+(uint32_t)(uint16_t)y*PICLINE_TOTAL_BYTES;
+#else
+        return drawbase+(uint32_t)(uint16_t)y*PICLINE_TOTAL_BYTES;
+#endif
+    }
+    inline void forget_line_address()
+    {
+#ifndef PICLINE_POW2
+        lasty=-32000;
+#endif
+    }
+
+    inline uint32_t next_line(uint32_t addr)
+    {
+        addr+=linesize;
+        if (addr>=drawbase+PICLINE_TOTAL_BYTES*YPIXELS)
+            addr-=PICLINE_TOTAL_BYTES*YPIXELS;
+        return addr;
+    }
+
+    inline uint32_t prev_line(uint32_t addr)
+    {
+        if (addr<drawbase+PICLINE_TOTAL_BYTES)
+            addr+=PICLINE_TOTAL_BYTES*YPIXELS;
+        return addr-linesize;
+    }
+
+    // number of screen lines starting from y that are in sequential
+    // picture lines, for operations that move several lines at once
+    inline int16_t lines_to_wrap(int16_t y)
+    {
+        y+=topline[drawpage];
+        if (y>=height)
+            y-=height;
+        return height-y;
+    }
     
-    // implement these platform specific methods in derived class
-    // SPI must be configured to  MSB first, MODE0
-    virtual uint8_t spi_byte(uint8_t out) = 0;
-    virtual void spi_select(bool onoff) = 0;
+    // transport, SPI must be configured to  MSB first, MODE0
+    inline T& bus() { return *static_cast<T*>(this); }
+    // chip select keeps track of open transaction so that queued
+    // block moves can be started from interrupt handler
+    volatile bool spiopen;
+    inline void select(bool onoff)
+    {
+        if (onoff) {
+            spiopen=true;
+            bus().spi_select(true);
+        }
+        else {
+            bus().spi_select(false);
+            spiopen=false;
+        }
+    }
+    // default bulk transfers for the currently selected transaction,
+    // these just loop over spi_byte()
+    void spi_write(const uint8_t *buf,uint16_t count);
+    void spi_fill(uint8_t data,uint16_t count);
+    void spi_read(uint8_t *buf,uint16_t count);
     
-    // these all rely on two virtuals above
+    // these all rely on the transport methods
     uint16_t spi_word(uint16_t out);
     void spi_write_program(uint32_t data);
+    void mem_select(uint8_t cmd,uint32_t addr);
+    void mem_write(uint32_t addr,const uint8_t *buf,uint16_t count);
+    void mem_fill(uint32_t addr,uint8_t data,uint16_t count);
+    void mem_read(uint32_t addr,uint8_t *buf,uint16_t count);
     uint16_t mem_write_word(uint32_t addr,uint16_t data);
     uint8_t mem_write_byte(uint32_t addr,uint8_t data);
     uint8_t mem_read_byte(uint32_t addr);
     uint8_t reg_byte(uint8_t regop,uint8_t data);
     uint8_t reg_word(uint8_t regop,uint16_t data);
     void blitter_op(uint32_t src, uint8_t w, uint8_t h, uint32_t dst, uint8_t backwards);
+    void blitter_setup(uint32_t src, uint8_t w, uint8_t h, uint32_t dst, uint8_t backwards);
+    void soft_move(uint32_t src, uint16_t w, uint8_t h, uint32_t dst, uint8_t backwards);
+    void blitter_start();
+    void column_write(uint32_t addr,uint16_t w,int16_t h,uint8_t color,uint16_t pair);
+
+    // queue of block moves waiting to be started, size must be power of 2
+    struct blitcmd_t {
+        uint32_t src,dst;
+        uint8_t w,h,backwards;
+    };
+    blitcmd_t blitqueue[BLITQUEUE];
+    volatile uint8_t blithead,blittail;
+    volatile bool blitdraining;
+    bool blitloaded;
+    void blit_queue(uint32_t src, uint8_t w, uint8_t h, uint32_t dst, uint8_t backwards);
+
+    // what the block mover was found to do at init. moves narrower than
+    // blitminw are done through buffer, moves of several lines or of
+    // overlapping areas are split when these do not work. without
+    // working block mover all moves are done in software
+    bool blithw;
+    uint8_t blitminw;
+    uint8_t blitcaps;
+    bool blitter_test(uint16_t x,uint8_t w,uint8_t h,int8_t dx,int8_t dy);
+    void blitter_probe();
+    void move_lines(int16_t ys,int16_t yd,int16_t n);
 
 public:
 
@@ -77,7 +342,7 @@ public:
 
     // when the object is constructed, the subclass constructor has not
     // yet run, so no SPI operations in base class constructor allowed    
-    VS23S010();
+    VS23S010T();
 
     inline void enable_color(bool yesno)
     {
@@ -91,6 +356,16 @@ public:
     
     inline void set_colors(uint8_t fg,uint8_t bg) { fgcolor=fg; bgcolor=bg; }
     inline void set_pos(int16_t x,int16_t y) { cursorx=x; cursory=y; }
+    // with ring scrolling enabled the screen is scrolled by rotating the
+    // picture line indexes instead of moving the pixel data
+    inline void set_scroll_mode(bool ring) { ringscroll=ring; }
+    // page flipping. all drawing goes to the draw page, which can be
+    // different from the one shown. with vsync the flip waits until
+    // the picture area is not being displayed
+    void set_draw_page(uint8_t page);
+    void show_page(uint8_t page,bool vsync=true);
+    inline uint8_t draw_page() { return drawpage; }
+    inline uint8_t shown_page() { return showpage; }
 
     void init();
     // graphics primitives
@@ -100,15 +375,100 @@ public:
     void line(int16_t x1,int16_t y1,int16_t x2,int16_t y2,uint8_t color);
     void rect(int16_t x1,int16_t y1,int16_t x2,int16_t y2,uint8_t color);
     void filled_rect(int16_t x1,int16_t y1,int16_t x2,int16_t y2,uint8_t color);
+    void fill_triangle(int16_t x1,int16_t y1,int16_t x2,int16_t y2,int16_t x3,int16_t y3,uint8_t color);
+    void fill_polygon(const int16_t *points,uint8_t n,uint8_t color);
+    void circle(int16_t x,int16_t y,uint16_t r,uint8_t color);
+    void filled_circle(int16_t x,int16_t y,uint16_t r,uint8_t color);
+    void ellipse(int16_t x,int16_t y,uint16_t rx,uint16_t ry,uint8_t color);
+    void filled_ellipse(int16_t x,int16_t y,uint16_t rx,uint16_t ry,uint8_t color);
+    void arc(int16_t x,int16_t y,uint16_t r,int16_t start,int16_t end,uint8_t color);
+    void pie(int16_t x,int16_t y,uint16_t r,int16_t start,int16_t end,uint8_t color);
+    // images of 1, 4 or 8 bits per pixel
+    void draw_bitmap(int16_t x,int16_t y,uint16_t w,uint16_t h,const uint8_t *bits,uint8_t bpp,const uint8_t *palette=NULL);
+    void draw_bitmap_P(int16_t x,int16_t y,uint16_t w,uint16_t h,const uint8_t *bits_P,uint8_t bpp,const uint8_t *palette=NULL);
     // text rendering
     uint8_t char_width(uint8_t c,const FONT* font);
     int16_t blitchar(uint8_t c,int16_t x,int16_t y,const FONT* font);
     int16_t vblitchar(uint8_t c,int16_t x,int16_t y);
     void set_font(const FONT* font);    
+    bool set_font(const FONTATLAS* atlas);
     int16_t putc(uint8_t c);
     int16_t puts(char *s);
     int16_t puts(const char *s);
     int16_t printn(int32_t n);
     void scroll_up(int16_t lines);
     void scroll_down(int16_t lines);    
+    // sprites are rectangular images up to SPRITE_SIZE pixels square kept
+    // in video memory, and drawn by block mover. screen under a sprite is
+    // saved when it is drawn and put back when it moves or is hidden, so
+    // sprites need to be hidden when drawing under them, and overlapping
+    // ones hidden in reverse order of showing
+    void sprite_image(uint8_t s,uint8_t w,uint8_t h,const uint8_t *pixels_P);
+    void sprite_grab(uint8_t s,int16_t x,int16_t y,uint8_t w,uint8_t h);
+    void sprite_move(uint8_t s,int16_t x,int16_t y);
+    void sprite_hide(uint8_t s);
+    // tile map is a grid of tiles at x,y on screen, the tile images are
+    // kept in video memory, in TILE_LINES lines reserved for them. map
+    // is in RAM, cols*rows bytes row by row, and only cells that have
+    // changed since last update are drawn. up to 128 tiles, the high bit
+    // of map entry marks changed cell
+    void tile_map(uint8_t *map,uint8_t cols,uint8_t rows,uint8_t w,uint8_t h,int16_t x,int16_t y);
+    void tile_image(uint8_t t,const uint8_t *pixels_P);
+    void tile_grab(uint8_t t,int16_t x,int16_t y);
+    void tile_set(uint8_t col,uint8_t row,uint8_t t);
+    void tile_update();
+    // video memory past the picture is handed out in bands of whole lines
+    // with picture line stride, these can be copied to screen by block
+    // mover. first fit from free list, bands that are given back are
+    // merged with free neighbours. when there is no room the fonts are
+    // thrown out of video memory, least recently used first. returns
+    // the first line of band, or -1 when there is no room or no lines
+    // are asked
+    int16_t vmem_alloc(uint16_t lines);
+    bool vmem_free(int16_t line,uint16_t lines);
+    inline uint32_t vmem_address(int16_t line)
+    {
+        return BITMAP_BYTE_ADDRESS+(uint32_t)linesize*line;
+    }
+    // arena is a band of lines that is handed out in order, and given
+    // back all at once
+    struct vmem_arena_t {
+        int16_t line;
+        uint16_t lines;
+        uint16_t used;
+    };
+    bool arena_init(vmem_arena_t *a,uint16_t lines);
+    int16_t arena_alloc(vmem_arena_t *a,uint16_t lines);
+    inline void arena_reset(vmem_arena_t *a) { a->used=0; }
+    void arena_free(vmem_arena_t *a);
+    // queued block moves
+    void queue_copy(int16_t x1,int16_t y1,int16_t x2,int16_t y2,int16_t dx,int16_t dy);
+    uint8_t blit_drain();
+    void blit_flush();
 };
+
+// driver with transport bound at run time through virtual methods,
+// this is what the driver used to be before it became a template and
+// is kept for compatibility. drawing primitives pay for an indirect
+// call on every transport operation
+//
+class VS23S010 : public VS23S010T<VS23S010>
+{
+    friend class VS23S010T<VS23S010>;
+
+protected:
+
+    // implement these platform specific methods in derived class
+    // SPI must be configured to  MSB first, MODE0
+    virtual uint8_t spi_byte(uint8_t out) = 0;
+    virtual void spi_select(bool onoff) = 0;
+    // bulk transfers for the currently selected transaction. the default
+    // implementations just loop over spi_byte(), override these with tight
+    // register level loops that overlap loading the next byte with the
+    // transfer of the current one
+    virtual void spi_write(const uint8_t *buf,uint16_t count);
+    virtual void spi_fill(uint8_t data,uint16_t count);
+    virtual void spi_read(uint8_t *buf,uint16_t count);
+};
+
+extern template class VS23S010T<VS23S010>;
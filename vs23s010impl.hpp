@@ -0,0 +1,2421 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2022 Madis Kaal <mast@nomad.ee>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+#pragma once
+// driver implementation. as the driver is a template, this needs to be
+// included in the source file that defines a screen class bound to its
+// transport at compile time. the virtual VS23S010 adapter is instantiated
+// in vs23s010.cpp
+#include "vs23s010.hpp"
+#include <util/delay.h>
+
+
+// enable low-pass filter on luma for less color fringing
+// this introduces ugly spikes at start and end of pixel data
+// and as the spike in the start is in positive direction there
+// is a visible light line at the edge of visible pixel area.
+// this is super annoying. even more so as the filter does not
+// remove the color fringing completely.
+// define to 0 to disable the filtering
+
+#define LUMAFILTER  (BLOCKMVC1_PYF)
+
+// this is empty placeholder font that gets used until
+// real font is loaded. it just just one character defined.
+
+static uint8_t const emptychar[] PROGMEM = {
+  0xfe,
+  0x82,
+  0x82,
+  0x82,
+  0x82,
+  0x82,
+  0x82,
+  0xfe,
+  0x00,
+  0x00
+};
+
+static const FONT emptyfont = {
+    .firstchar = 32,
+    .lastchar = 32,
+    .height = 10,
+    .width = 8,
+    .widths_P = NULL,
+    .bitmaps_P = {emptychar}
+};
+
+template <class T>
+VS23S010T<T>::VS23S010T() : vmemchars(0), vfreecount(1), fontclock(0),
+                        spriteband(-1), tilemap(NULL), tileband(-1),
+                        drawpage(0),
+                        showpage(0), drawbase(PAGE_BYTE_ADDRESS(0)),
+                        ringscroll(false), spiopen(false), blithead(0),
+                        blittail(0), blitdraining(false), blitloaded(false),
+                        blithw(false), blitminw(1),
+                        blitcaps(BLIT_MULTILINE|BLIT_OVERLAP),
+                        fgcolor(15), 
+                        bgcolor(0), cursorx(0), cursory(0)
+{
+    for (uint8_t i=0;i<PAGES;i++)
+        topline[i]=0;
+    forget_line_address();
+    vfree[0].line=0;
+    vfree[0].lines=BITMAP_LINES;
+    for (uint8_t i=0;i<FONTSLOTS;i++)
+        fontslots[i].font=NULL;
+    fontslot=FONTSLOTS;
+    current_font=&emptyfont;
+    for (uint8_t i=0;i<SPRITES;i++) {
+        sprites[i].w=0;
+        sprites[i].shown=false;
+    }
+}
+
+// protoline used by a line of the frame outside of picture area, these
+// build the frame beginning and end
+template <class T>
+uint8_t VS23S010T<T>::sync_protoline(uint16_t line)
+{
+#ifdef PAL_VIDEO
+    if (line<2)
+        return 2;
+    if (line==2)
+        return 3;
+    if (line<5 || line>=TOTAL_LINES-3) // and last lines 310-312
+        return 1;
+#endif
+#ifdef NTSC_VIDEO
+    if (line<4 || (line>=7 && line<10))
+        return 1;
+    if (line<7)
+        return 2;
+#endif
+    return 0;
+}
+
+// write complete line index table of draw page in one sequential
+// transfer. lines outside of picture point to protolines, picture lines
+// to their picture data rotated by topline
+template <class T>
+void VS23S010T<T>::set_index_table()
+{
+    uint32_t addr=line_address(0);
+    mem_select(WRITE,INDEX_TABLE_BYTE_ADDRESS(drawpage));
+    for (uint16_t i=0;i<TOTAL_LINES;i++) {
+        uint8_t index[3];
+        if (i>=STARTLINE && i<STARTLINE+height) {
+            index[0]=(addr << 7) & 0x80;
+            index[1]=addr >> 1;
+            index[2]=addr >> 9;
+            addr=next_line(addr);
+        }
+        else {
+            uint16_t w=PROTOLINE_WORD_ADDRESS(sync_protoline(i));
+            index[0]=0;
+            index[1]=w;
+            index[2]=w >> 8;
+        }
+        bus().spi_write(index,3);
+    }
+    select(false);
+}
+
+// point the indexes of all visible lines of draw page to their picture
+// lines, rotated by topline. all indexes are sent in one sequential write
+template <class T>
+void VS23S010T<T>::set_picture_indexes()
+{
+    uint32_t addr=line_address(0);
+    mem_select(WRITE,INDEX_TABLE_BYTE_ADDRESS(drawpage)+STARTLINE*3);
+    for (int16_t i=0;i<height;i++) {
+        uint8_t index[3]={(uint8_t)((addr << 7) & 0x80),(uint8_t)(addr >> 1),
+                          (uint8_t)(addr >> 9)};
+        bus().spi_write(index,3);
+        addr=next_line(addr);
+    }
+    select(false);
+}
+
+// write limit number of data words to given protoline starting at offset
+// all words go in one sequential transfer
+template <class T>
+void VS23S010T<T>::protoline(uint16_t line, uint16_t offset, uint16_t limit, uint16_t data)
+{
+    mem_select(WRITE,(uint32_t)(PROTOLINE_WORD_ADDRESS(line) + offset)*2);
+    do {
+        bus().spi_byte(data>>8);
+        bus().spi_byte(data);
+    } while (limit--);
+    select(false);
+}
+
+// low level SPI interface and command helpers
+// these all rely on spi_select() and spi_byte() of the transport, bulk
+// transfers below are only used when the transport does not have its own
+template <class T>
+void VS23S010T<T>::spi_write(const uint8_t *buf,uint16_t count)
+{
+    while (count--) {
+        bus().spi_byte(*buf++);
+    }
+}
+
+template <class T>
+void VS23S010T<T>::spi_fill(uint8_t data,uint16_t count)
+{
+    while (count--) {
+        bus().spi_byte(data);
+    }
+}
+
+template <class T>
+void VS23S010T<T>::spi_read(uint8_t *buf,uint16_t count)
+{
+    while (count--) {
+        *buf++=bus().spi_byte(0);
+    }
+}
+
+template <class T>
+uint16_t VS23S010T<T>::spi_word(uint16_t out)
+{
+    uint16_t w;
+    w=bus().spi_byte(out>>8);
+    w<<=8;
+    w|=bus().spi_byte(out&255);
+    return w;
+}
+
+template <class T>
+void VS23S010T<T>::spi_write_program(uint32_t data)
+{
+    uint8_t cmd[5]={PROGRAM,(uint8_t)(data>>24),(uint8_t)(data>>16),
+                    (uint8_t)(data>>8),(uint8_t)data};
+    select(true);
+    bus().spi_write(cmd,sizeof(cmd));
+    select(false);
+}
+
+// selects the chip and sends memory command with 24 bit byte address,
+// leaving the transaction open for data transfer
+template <class T>
+void VS23S010T<T>::mem_select(uint8_t cmd,uint32_t addr)
+{
+    uint8_t hdr[4]={cmd,(uint8_t)(addr>>16),(uint8_t)(addr>>8),(uint8_t)addr};
+    select(true);
+    bus().spi_write(hdr,sizeof(hdr));
+}
+
+// sequential memory access, these rely on memory being set to
+// autoincrementing mode in init()
+template <class T>
+void VS23S010T<T>::mem_write(uint32_t addr,const uint8_t *buf,uint16_t count)
+{
+    mem_select(WRITE,addr);
+    bus().spi_write(buf,count);
+    select(false);
+}
+
+template <class T>
+void VS23S010T<T>::mem_fill(uint32_t addr,uint8_t data,uint16_t count)
+{
+    mem_select(WRITE,addr);
+    bus().spi_fill(data,count);
+    select(false);
+}
+
+template <class T>
+void VS23S010T<T>::mem_read(uint32_t addr,uint8_t *buf,uint16_t count)
+{
+    mem_select(READ,addr);
+    bus().spi_read(buf,count);
+    select(false);
+}
+
+template <class T>
+uint16_t VS23S010T<T>::mem_write_word(uint32_t addr,uint16_t data)
+{
+    uint16_t w;
+    mem_select(WRITE,addr<<1);
+    w=spi_word(data);
+    select(false);
+    return w;
+}
+
+template <class T>
+uint8_t VS23S010T<T>::mem_write_byte(uint32_t addr,uint8_t data)
+{
+    uint8_t b;
+    mem_select(WRITE,addr);
+    b=bus().spi_byte(data);
+    select(false);
+    return b;
+}
+
+template <class T>
+uint8_t VS23S010T<T>::mem_read_byte(uint32_t addr)
+{
+    uint8_t b;
+    mem_select(READ,addr);
+    b=bus().spi_byte(0);
+    select(false);
+    return b;
+}
+
+
+template <class T>
+uint8_t VS23S010T<T>::reg_byte(uint8_t regop,uint8_t data)
+{
+    uint8_t b;
+    select(true);
+    bus().spi_byte(regop);
+    b=bus().spi_byte(data);
+    select(false);
+    return b;
+}
+
+template <class T>
+uint8_t VS23S010T<T>::reg_word(uint8_t regop,uint16_t data)
+{
+    uint16_t w;
+    select(true);
+    bus().spi_byte(regop);
+    w=spi_word(data);
+    select(false);
+    return w;
+}
+
+// much of initialization magic comes directly from VLSI forum posts
+// although a bit optimized, cleaned up and made switchable between
+// PAL and NTSC
+
+template <class T>
+void VS23S010T<T>::init()
+{
+    reg_byte(WRITE_MULTIIC,0xe); // only leave chip 0 enables in case of
+                                 // multichip setup
+    reg_byte(WRITE_STATUS,0x40); // memory access to autoincrementing
+                                 // sequential mode
+    reg_word(PICSTART,(STARTPIX-1)); // left and right limit of visible
+    reg_word(PICEND,(ENDPIX-1));     // screen area
+    // enable PLL clock
+    reg_word(VDCTRL1,(VDCTRL1_PLL_ENABLE)|(VDCTRL1_SELECT_PLL_CLOCK));
+    // Clear protoline area by filling it with 0, this sets protolines
+    // to SYNC_LEVEL which is always 0. Line index tables get fully written
+    // below, and picture area is cleared with block mover once the
+    // clock is running
+    mem_fill(0,0,INDEX_START_BYTES);
+    // Set length of one complete line (in PLL (VClk) clocks). 
+    // Does not include the fixed 10 cycles of sync level at the beginning 
+    // of the lines. 
+    reg_word(LINELEN,PLLCLKS_PER_LINE);
+    // Set microcode program for picture lines. Each OP is one VClk cycle.
+    spi_write_program(MICROCODE);
+    // Define where Line Indexes are stored in memory
+    reg_word(INDEXSTART,INDEX_START_LONGWORDS);
+    // At this time, the chip would continuously output the proto line 0.
+    // This protoline will become our most "normal" horizontal line.
+    // For TV-Out, fill the line with black level,
+    // and insert a few pixels of sync level (0) and color burst to the beginning.
+    // Note that the chip hardware adds black level to all nonproto areas so
+    // protolines and normal picture have different meaning for the same Y value.
+    // In protolines, Y=0 is at sync level and in normal picture Y=0 is at black level (offset +102).
+
+    // In protolines, each pixel is 8 PLLCLKs, which in TV-out modes means one color
+    // subcarrier cycle. Each pixel has 16 bits (one word): VVVVUUUUYYYYYYYY.
+
+    protoline(0,0,COLORCLKS_PER_PROTO_LINE,BLANK_LEVEL);
+    protoline(0,0,SYNC_DUR,SYNC_LEVEL);
+#ifdef NTSC_VIDEO
+    protoline(0,BLANKEND,STARTPIX-BLANKEND,BLACK_LEVEL);
+#endif
+    enable_color(true);
+    // protoline 1, short+short VSYNC line
+    protoline(1,0,SHORTSYNC,SYNC_LEVEL);
+    protoline(1,COLORCLKS_PROTO_LINE_HALF,SHORTSYNCM,SYNC_LEVEL);
+    // protoline 2, long+long VSYNC line
+    protoline(2,0,LONGSYNC,SYNC_LEVEL);
+    protoline(2,COLORCLKS_PROTO_LINE_HALF,LONGSYNCM,SYNC_LEVEL);
+#ifdef PAL_VIDEO
+    // extra protoline for progressive PAL
+    // protoline 3, long+short VSYNC line
+    protoline(3,0,LONGSYNC,SYNC_LEVEL);
+    protoline(3,COLORCLKS_PROTO_LINE_HALF,SHORTSYNCM,SYNC_LEVEL);
+#endif
+    // every page gets its own line index table, these only differ in
+    // picture lines they point to
+    for (uint8_t page=PAGES;page--;) {
+        set_draw_page(page);
+        set_index_table();
+    }
+    // Enable Video Display Controller, set video mode,program length and line count
+    reg_word(VDCTRL2, 
+        VDCTRL2_ENABLE_VIDEO |
+#ifdef NTSC_VIDEO
+        VDCTRL2_NTSC |
+#endif
+#ifdef PAL_VIDEO
+        VDCTRL2_PAL |
+#endif
+        VDCTRL2_PROGRAM_LENGTH |
+        VDCTRL2_LINECOUNT);
+    // block mover is clocked by the video line engine, so it is tried
+    // out and the picture cleared only once video is running. the probe
+    // uses picture lines that get cleared next
+    blitter_probe();
+    // clear picture area of all pages by writing first line and then
+    // doubling the cleared area with every block move. lines of pages
+    // follow each other in memory, so this is done as one tall area.
+    // without working block mover every line is written
+    uint32_t pic=PICLINE_BYTE_ADDRESS(0);
+    mem_fill(pic,0,linesize);
+    for (uint16_t done=1;done<(uint16_t)YPIXELS*PAGES;) {
+        if (!blithw) {
+            mem_fill(pic+(uint32_t)linesize*done,0,linesize);
+            done++;
+            continue;
+        }
+        uint16_t n=(uint16_t)YPIXELS*PAGES-done;
+        if (n>done)
+            n=done;
+        if (n>255)
+            n=255;
+        // lines are done in columns that block mover can handle
+        const uint8_t columns=(linesize+254)/255;
+        for (uint8_t c=0;c<columns;c++) {
+            uint16_t x=(uint16_t)linesize*c/columns;
+            uint8_t w=(uint16_t)linesize*(c+1)/columns-x;
+            blitter_op(pic+x,w,n,pic+(uint32_t)linesize*done+x,0);
+        }
+        done+=n;
+    }
+    if (blithw)
+        while (block_move_active());
+    select(true);
+    bus().spi_byte(BLOCKMVC1);
+    bus().spi_fill(0,4);
+    bus().spi_byte(LUMAFILTER);
+    select(false);
+}
+
+// select page that drawing operations go to
+template <class T>
+void VS23S010T<T>::set_draw_page(uint8_t page)
+{
+    if (page>=PAGES)
+        return;
+    drawpage=page;
+    drawbase=PAGE_BYTE_ADDRESS(page);
+    forget_line_address();
+}
+
+// flipping a page is just pointing the video controller to another line
+// index table. index tables of all pages point to the same protolines for
+// lines outside of picture area, so the switch is invisible if it is done
+// while these lines are being displayed. CURLINE is polled for that.
+template <class T>
+void VS23S010T<T>::show_page(uint8_t page,bool vsync)
+{
+    if (page>=PAGES)
+        return;
+    while (vsync) {
+        uint16_t line=reg_word(CURLINE,0x0000)&0x3ff;
+        if (line<STARTLINE || line>=ENDLINE)
+            break;
+    }
+    reg_word(INDEXSTART,INDEX_TABLE_LONGWORDS(page));
+    showpage=page;
+}
+
+// simplest one, set one pixel at coordinates to desired color
+//
+template <class T>
+void VS23S010T<T>::set_pixel(int16_t x, int16_t y, uint8_t color)
+{
+    if ((x<0) || (x>(XPIXELS-1)) || (y<0) || (y>(YPIXELS-1)))
+        return;
+    uint32_t addr=line_address(y)+x;
+    mem_write_byte(addr,color);
+}
+
+// the block moving feature seems to be one very sick puppy,
+// it fails if asked to copy less than 4 bytes, looks like it cannot copy
+// overlapping regions if the regions overlap by just a single pixel and who
+// knows what other failure scenarios it has. what the chip at hand can do
+// is found by blitter_probe() at init, moves of several lines are split
+// here if these do not work, and callers keep moves narrower than
+// blitminw and overlapping ones away from it.
+// for verification that the problem is block mover related, a software
+// alternative is also available, it is used when the block mover
+// does not work at all, or when HARDWARE_BLITTER is not defined
+//
+#define HARDWARE_BLITTER
+template <class T>
+void VS23S010T<T>::blitter_op(uint32_t src, uint8_t w, uint8_t h, uint32_t dst, uint8_t backwards)
+{
+    if (!blithw) {
+        soft_move(src,w,h,dst,backwards);
+        return;
+    }
+    // moves already in queue have to be started first
+    while (blit_drain())
+        ;
+    if (!(blitcaps&BLIT_MULTILINE)) {
+        while (h--) {
+            blitter_setup(src,w,1,dst,backwards);
+            blitter_start();
+            src=backwards?src-linesize:src+linesize;
+            dst=backwards?dst-linesize:dst+linesize;
+        }
+        return;
+    }
+    blitter_setup(src,w,h,dst,backwards);
+    blitter_start();
+}
+
+// block move done in software, with same parameters as block mover
+// takes. every line is read into buffer and written back in pieces of
+// BLIT_BUFFER bytes, each one a sequential read and write. backwards
+// moves go from the end of lines and from the last line, so moves where
+// areas overlap work the same way as with block mover
+template <class T>
+void VS23S010T<T>::soft_move(uint32_t src, uint16_t w, uint8_t h, uint32_t dst, uint8_t backwards)
+{
+    uint8_t buf[BLIT_BUFFER];
+    while (h--) {
+        for (uint16_t i=0;i<w;) {
+            uint8_t n=((w-i)>BLIT_BUFFER)?BLIT_BUFFER:w-i;
+            i+=n;
+            uint32_t s=backwards?src-i+1:src+i-n;
+            uint32_t d=backwards?dst-i+1:dst+i-n;
+            mem_read(s,buf,n);
+            mem_write(d,buf,n);
+        }
+        src=backwards?src-linesize:src+linesize;
+        dst=backwards?dst-linesize:dst+linesize;
+    }
+}
+
+// write block move parameters. accouring to VLSI forum, the block move
+// paramters are shadowed, so this can be done while previous move is still
+// running
+template <class T>
+void VS23S010T<T>::blitter_setup(uint32_t src, uint8_t w, uint8_t h, uint32_t dst, uint8_t backwards)
+{
+    uint8_t cmd[6];
+    cmd[0]=BLOCKMVC1;
+    cmd[1]=src>>9;
+    cmd[2]=src>>1;
+    cmd[3]=dst>>9;
+    cmd[4]=dst>>1;
+    cmd[5]=((src&1)<<2) |
+        ((dst&1)<<1) |
+        LUMAFILTER |
+        (backwards?1:0); // move direction, 1 is backwards
+    select(true);
+    bus().spi_write(cmd,6);
+    select(false);    
+    cmd[0]=BLOCKMVC2;
+    cmd[1]=(linesize-w)>>8;
+    cmd[2]=(linesize-w);
+    cmd[3]=w;
+    cmd[4]=h-1;
+    select(true);
+    bus().spi_write(cmd,5);
+    select(false);
+}
+
+// start the move that was set up last, once the previous one has ended.
+// This checking would be more effective with hardware not no free pins on
+// AVR and I would also like to see if SPI only can do it
+template <class T>
+void VS23S010T<T>::blitter_start()
+{
+    while (block_move_active());
+    select(true);
+    bus().spi_byte(BLOCKMVST);
+    select(false);
+}
+
+// tries a move of w by h area at x on picture line 1 by dx,dy on the
+// first picture lines, the way queue_copy() would do it, and checks that
+// the moved pixels and the ones around them are what they should be.
+// the area is filled with pattern that differs for every offset the
+// move can have
+template <class T>
+bool VS23S010T<T>::blitter_test(uint16_t x,uint8_t w,uint8_t h,int8_t dx,int8_t dy)
+{
+    uint32_t pic=PICLINE_BYTE_ADDRESS(0);
+    uint8_t lines=h+2+((dy>0)?dy:0);
+    int16_t x1=x-2+((dx<0)?dx:0);
+    int16_t x2=x+w+1+((dx>0)?dx:0);
+    for (uint8_t l=0;l<lines;l++) {
+        mem_select(WRITE,pic+(uint32_t)linesize*l+x1);
+        for (int16_t i=x1;i<=x2;i++)
+            bus().spi_byte(l*61+i*13+5);
+        select(false);
+    }
+    uint32_t src=pic+linesize+x;
+    uint32_t dst=src+(int32_t)linesize*dy+dx;
+    uint8_t backwards=(dy>0 || (dy==0 && dx>0));
+    if (backwards) {
+        src+=(uint32_t)linesize*(h-1)+w-1;
+        dst+=(uint32_t)linesize*(h-1)+w-1;
+    }
+    blitter_setup(src,w,h,dst,backwards);
+    blitter_start();
+    while (block_move_active());
+    bool ok=true;
+    for (uint8_t l=0;l<lines;l++) {
+        mem_select(READ,pic+(uint32_t)linesize*l+x1);
+        for (int16_t i=x1;i<=x2;i++) {
+            int16_t sl=l,si=i;
+            if (l>=1+dy && l<1+dy+h && i>=x+dx && i<x+dx+w) {
+                sl-=dy;
+                si-=dx;
+            }
+            if (bus().spi_byte(0)!=(uint8_t)(sl*61+si*13+5))
+                ok=false;
+        }
+        select(false);
+    }
+    return ok;
+}
+
+// block mover is tried out with moves of increasing difficulty. the
+// narrowest width that works is looked for from 8 down, at both odd and
+// even addresses, and widest possible move must also work for the mover
+// to be used at all. moves of several lines, and moves of overlapping
+// areas up, down, left and right by one pixel are tried next
+template <class T>
+void VS23S010T<T>::blitter_probe()
+{
+    blithw=false;
+    blitminw=1;
+    blitcaps=BLIT_MULTILINE|BLIT_OVERLAP;
+#ifdef HARDWARE_BLITTER
+    uint8_t minw=0;
+    for (uint8_t w=8;w;w--) {
+        if (!blitter_test(16,w,1,0,1) || !blitter_test(17,w,1,1,1))
+            break;
+        minw=w;
+    }
+    if (!minw || !blitter_test(16,255,1,1,1))
+        return;
+    blithw=true;
+    blitminw=minw;
+    blitcaps=0;
+    if (!blitter_test(16,40,3,0,3) || !blitter_test(17,minw,3,-1,3))
+        return;
+    blitcaps|=BLIT_MULTILINE;
+    if (blitter_test(16,40,3,0,-1) && blitter_test(16,40,3,0,1) &&
+        blitter_test(16,40,1,1,0) && blitter_test(17,40,1,-1,0))
+        blitcaps|=BLIT_OVERLAP;
+#endif
+}
+
+// queued block moves let the caller get on with other work while the
+// moves are carried out. queue is drained by calling blit_drain(), each
+// call loads the parameters of next move into shadow registers if not
+// done yet, and if the block mover has become idle then starts the move
+// and loads parameters of the one after it. drain can be called from
+// timer interrupt, it does nothing if interrupted code was in the middle
+// of SPI transaction. returns number of moves not started yet.
+// only the order of queued moves among themselves and with blitter_op()
+// is kept, pixels drawn directly can get ahead of queued moves
+template <class T>
+uint8_t VS23S010T<T>::blit_drain()
+{
+    if (blitdraining || spiopen)
+        return (uint8_t)(blittail-blithead);
+    blitdraining=true;
+    while (blithead!=blittail) {
+        blitcmd_t *b=&blitqueue[blithead&(BLITQUEUE-1)];
+        if (!blithw) {
+            blitter_op(b->src,b->w,b->h,b->dst,b->backwards);
+            blithead++;
+            continue;
+        }
+        if (!blitloaded) {
+            blitter_setup(b->src,b->w,b->h,b->dst,b->backwards);
+            blitloaded=true;
+        }
+        if (block_move_active())
+            break;
+        select(true);
+        bus().spi_byte(BLOCKMVST);
+        select(false);
+        blitloaded=false;
+        blithead++;
+    }
+    blitdraining=false;
+    return (uint8_t)(blittail-blithead);
+}
+
+template <class T>
+void VS23S010T<T>::blit_queue(uint32_t src, uint8_t w, uint8_t h, uint32_t dst, uint8_t backwards)
+{
+    // a line at a time when block mover cannot do more
+    if (h>1 && blithw && !(blitcaps&BLIT_MULTILINE)) {
+        while (h--) {
+            blit_queue(src,w,1,dst,backwards);
+            src=backwards?src-linesize:src+linesize;
+            dst=backwards?dst-linesize:dst+linesize;
+        }
+        return;
+    }
+    while ((uint8_t)(blittail-blithead)>=BLITQUEUE)
+        blit_drain();
+    blitcmd_t *b=&blitqueue[blittail&(BLITQUEUE-1)];
+    b->src=src;
+    b->w=w;
+    b->h=h;
+    b->dst=dst;
+    b->backwards=backwards;
+    blittail++;
+    blit_drain();
+}
+
+// wait until all queued moves have been carried out
+template <class T>
+void VS23S010T<T>::blit_flush()
+{
+    while (blit_drain())
+        ;
+    if (blithw)
+        while (block_move_active());
+}
+
+// queue a copy of screen area x1,y1-x2,y2 to dx,dy. copy is done line
+// by line, in the order that works when the areas overlap. areas narrower
+// than block mover can do, and overlapping ones on the same lines if it
+// cannot do these, are copied right away with soft_move()
+template <class T>
+void VS23S010T<T>::queue_copy(int16_t x1,int16_t y1,int16_t x2,int16_t y2,int16_t dx,int16_t dy)
+{
+    if (x1<0) {
+        dx-=x1;
+        x1=0;
+    }
+    if (y1<0) {
+        dy-=y1;
+        y1=0;
+    }
+    if (dx<0) {
+        x1-=dx;
+        dx=0;
+    }
+    if (dy<0) {
+        y1-=dy;
+        dy=0;
+    }
+    if (x2>(width-1))
+        x2=width-1;
+    if (y2>(height-1))
+        y2=height-1;
+    if (dx+(x2-x1)>(width-1))
+        x2=width-1-dx+x1;
+    if (dy+(y2-y1)>(height-1))
+        y2=height-1-dy+y1;
+    if (x1>x2 || y1>y2)
+        return;
+    int16_t w=x2-x1+1;
+    int16_t c=y2-y1+1;
+    int16_t step=1;
+    if (dy>y1) {
+        // moving down, start from the bottom
+        dy+=y2-y1;
+        y1=y2;
+        step=-1;
+    }
+    // overlapping move to the right on same line has to be done backwards
+    uint8_t backwards=(dy==y1 && dx>x1);
+    bool buffered=(w<blitminw || (dy==y1 && !(blitcaps&BLIT_OVERLAP) &&
+        dx-x1<w && x1-dx<w));
+    // lines wider than the mover can do go in equal parts, so that none
+    // of them is narrower than blitminw
+    uint8_t parts=(w+254)/255;
+    while (c--) {
+        uint32_t src=line_address(y1)+x1;
+        uint32_t dst=line_address(dy)+dx;
+        if (buffered) {
+            blit_flush();
+            if (backwards)
+                soft_move(src+w-1,w,1,dst+w-1,1);
+            else
+                soft_move(src,w,1,dst,0);
+        }
+        else {
+            if (backwards) {
+                src+=w-1;
+                dst+=w-1;
+            }
+            for (uint8_t p=0;p<parts;p++) {
+                int16_t i=(int16_t)(((int32_t)w*p)/parts);
+                uint8_t n=(int16_t)(((int32_t)w*(p+1))/parts)-i;
+                if (backwards)
+                    blit_queue(src-i,n,1,dst-i,1);
+                else
+                    blit_queue(src+i,n,1,dst+i,0);
+            }
+        }
+        y1+=step;
+        dy+=step;
+    }
+}
+
+// writes w pixels wide column of color on h lines from addr. every line
+// is one transaction, for narrow columns the write command and pixels
+// are kept in a buffer where only the address changes. with pair the
+// same pixels are also written at addr+pair on each line, for the two
+// sides of rectangle
+template <class T>
+void VS23S010T<T>::column_write(uint32_t addr,uint16_t w,int16_t h,uint8_t color,uint16_t pair)
+{
+    uint8_t buf[4+8];
+    uint8_t n=4;
+    buf[0]=WRITE;
+    if (w<=8) {
+        while (n<4+w)
+            buf[n++]=color;
+    }
+    while (h-->0) {
+        uint32_t a=addr;
+        for (;;) {
+            buf[1]=a>>16;
+            buf[2]=a>>8;
+            buf[3]=a;
+            select(true);
+            bus().spi_write(buf,n);
+            if (n==4)
+                bus().spi_fill(color,w);
+            select(false);
+            if (!pair || a!=addr)
+                break;
+            a+=pair;
+        }
+        addr=next_line(addr);
+    }
+}
+
+// filled rectangle drawing first clips the rectangle into visual area
+// then draws the top line of the rectangle, and uses hardware block mover
+// to copy the lines that are already done to below them, doubling the
+// filled area with every move. 240 lines take 8 moves instead of 239.
+// The mover cannot do more than 255 bytes wide, so wider rectangles are
+// done in equal width columns, and moves are split where picture lines
+// wrap around in ring scroll mode. columns narrower than the block mover
+// can do are written line by line, as are narrow ones of few lines that
+// are cheaper to write, a move costs about as much as writing 8 pixels
+//
+template <class T>
+void VS23S010T<T>::filled_rect(int16_t x1,int16_t y1,int16_t x2,int16_t y2,uint8_t color)
+{
+    if (y1>(height-1) || x1>(width-1))
+        return;
+    if (x1<0)
+        x1=0;
+    if (y1<0)
+        y1=0;
+    if (x2>(width-1))
+        x2=width-1;
+    if (y2>(height-1))
+        y2=height-1;
+    if (x1>x2 || y1>y2)
+        return;
+    uint32_t addr=line_address(y1)+x1;
+    int16_t w=x2-x1+1;
+    int16_t h=y2-y1+1;
+    if (!blithw || w<blitminw || (w<8 && h<BLIT_MIN_LINES)) {
+        column_write(addr,w,h,color,0);
+        return;
+    }
+    mem_fill(addr,color,w);
+    uint8_t columns=(w+254)/255;
+    for (uint8_t c=0;c<columns;c++) {
+        int16_t cx=x1+(int16_t)(((int32_t)w*c)/columns);
+        uint8_t cw=x1+(int16_t)(((int32_t)w*(c+1))/columns)-cx;
+        int16_t done=1;
+        while (done<h) {
+            // largest run of finished lines that is sequential in memory
+            int16_t s=y1;
+            int16_t n=done;
+            int16_t k=lines_to_wrap(y1);
+            if (k<n) {
+                if (n-k>k) {
+                    s=y1+k;
+                    n-=k;
+                }
+                else
+                    n=k;
+            }
+            if (n>h-done)
+                n=h-done;
+            if (n>255)
+                n=255;
+            k=lines_to_wrap(y1+done);
+            if (n>k)
+                n=k;
+            blitter_op(line_address(s)+cx,cw,n,line_address(y1+done)+cx,0);
+            done+=n;
+        }
+    }
+    // last move can be large, pixels drawn next must not get overwritten
+    // by it
+    if (h>1)
+        while (block_move_active());
+}
+
+// vertical line is a column of filled_rect() one pixel wide. if the block
+// mover was found to do moves that narrow, the line is copied down with
+// doubling moves, otherwise it is written line by line
+//
+template <class T>
+void VS23S010T<T>::vline(int16_t x,int16_t y1,int16_t y2,uint8_t color)
+{
+    filled_rect(x,y1,x,y2,color);
+}
+
+// generic line drawing with Bresenham algorithm. line is drawn along its
+// major axis, and the steps where it is outside of visible area are
+// skipped by calculating the error term for first visible pixel, so
+// clipped line has exactly the same pixels as unclipped one. mostly
+// horizontal lines are drawn as horizontal runs, each one a single
+// sequential write. mostly vertical lines need a write for every pixel,
+// but line address is stepped from previous one, not calculated for
+// every pixel
+template <class T>
+void VS23S010T<T>::line(int16_t x1,int16_t y1,int16_t x2,int16_t y2,uint8_t color)
+{
+    // vline and hline want their ends in increasing order
+    if (x1==x2) {
+        if (y1>y2)
+            vline(x1,y2,y1,color);
+        else
+            vline(x1,y1,y2,color);
+        return;
+    }
+    if (y1==y2) {
+        if (x1>x2)
+            hline(x2,y1,x1,color);
+        else
+            hline(x1,y1,x2,color);
+        return;
+    }
+    int32_t dx=(x2>x1)?(int32_t)x2-x1:(int32_t)x1-x2;
+    int32_t dy=(y2>y1)?(int32_t)y2-y1:(int32_t)y1-y2;
+    bool shallow=(dx>=dy);
+    // draw in increasing direction of major axis
+    if (shallow?(x1>x2):(y1>y2)) {
+        int16_t t=x1; x1=x2; x2=t;
+        t=y1; y1=y2; y2=t;
+    }
+    int16_t a=shallow?x1:y1;      // major axis start
+    int16_t b=shallow?y1:x1;      // minor axis start
+    int32_t da=shallow?dx:dy;
+    int32_t db=shallow?dy:dx;
+    bool up=shallow?(y2<y1):(x2<x1); // minor axis decreases
+    int16_t amax=shallow?width-1:height-1;
+    int16_t bmax=shallow?height-1:width-1;
+    int32_t e0=da/2;
+    // after k steps minor axis has moved (k*db-e0+da-1)/da, first visible
+    // step is where both coordinates are on screen, last one where
+    // either leaves the screen. products of two coordinate ranges do not
+    // fit in 32 bits near the ends of int16 range
+    int32_t kstart=(a<0)?-(int32_t)a:0;
+    int32_t need=up?(int32_t)b-bmax:-(int32_t)b;
+    if (need>0) {
+        int64_t k=((int64_t)(need-1)*da+e0)/db+1;
+        if (k>da)
+            return;
+        if (k>kstart)
+            kstart=k;
+    }
+    int32_t kend=(int32_t)amax-a;
+    if (kend>da)
+        kend=da;
+    int32_t lim=up?(int32_t)b:(int32_t)bmax-b;
+    if (lim<0)
+        return;
+    int64_t klim=((int64_t)lim*da+e0)/db;
+    if (klim<kend)
+        kend=klim;
+    if (kstart>kend)
+        return;
+    int32_t m=(kstart*db-e0+da-1)/da;
+    int32_t err=e0-kstart*db+m*da;
+    a+=kstart;
+    b+=up?-m:m;
+    int16_t n=kend-kstart;
+    if (shallow) {
+        uint32_t addr=line_address(b);
+        int16_t start=a;
+        while (n--) {
+            a++;
+            err-=db;
+            if (err<0) {
+                err+=da;
+                mem_fill(addr+start,color,a-start);
+                addr=up?prev_line(addr):next_line(addr);
+                start=a;
+            }
+        }
+        mem_fill(addr+start,color,a-start+1);
+    }
+    else {
+        uint32_t addr=line_address(a);
+        while (1) {
+            mem_write_byte(addr+b,color);
+            if (!n--)
+                break;
+            addr=next_line(addr);
+            err-=db;
+            if (err<0) {
+                err+=da;
+                b+=up?-1:1;
+            }
+        }
+    }
+}
+
+// rectangle outline. sides are drawn between top and bottom lines. when
+// the block mover can copy one pixel wide columns, each side is copied
+// down like vline(). otherwise both are written in the same pass, two
+// transactions on every line, a move of both would also copy the inside.
+// rectangles up to 2 pixels wide or high have no inside and are filled
+// instead
+template <class T>
+void VS23S010T<T>::rect(int16_t x1,int16_t y1,int16_t x2,int16_t y2,uint8_t color)
+{
+  if (x2-x1<2 || y2-y1<2) {
+      filled_rect(x1,y1,x2,y2,color);
+      return;
+  }
+  hline(x1,y1,x2,color);
+  hline(x1,y2,x2,color);
+  y1++;
+  y2--;
+  if (x1<0 || x2>(width-1) || y1>(height-1) || y2<0) {
+      vline(x1,y1,y2,color);
+      vline(x2,y1,y2,color);
+      return;
+  }
+  if (y1<0)
+      y1=0;
+  if (y2>(height-1))
+      y2=height-1;
+  if (blithw && blitminw<=1 && y2-y1+1>=BLIT_MIN_LINES) {
+      filled_rect(x1,y1,x1,y2,color);
+      filled_rect(x2,y1,x2,y2,color);
+      return;
+  }
+  column_write(line_address(y1)+x1,1,y2-y1+1,color,x2-x1);
+}
+
+
+// filled polygon of n points, given as x,y pairs. the polygon is drawn
+// line by line, with active edge table. edges are sorted by their top
+// line, and the ones crossing current line are kept in active list
+// sorted by x. pairs of crossings make spans, that are filled with
+// one sequential write each. when there is a single span on a line and
+// it is the same as on line above, the rectangle of them is drawn
+// together by filled_rect, which copies the lines with block mover.
+// vertices where edge continues in the same direction are counted once
+// by shortening the upper edge, so that all lines of polygon including
+// its top and bottom are filled. polygons with more than POLYGON_EDGES
+// points are not drawn
+template <class T>
+void VS23S010T<T>::fill_polygon(const int16_t *points,uint8_t n,uint8_t color)
+{
+    struct edge_t {
+        int16_t ytop,ybot;
+        int32_t x,dx;       // x on current line and step, 16.16 fixed point
+    };
+    edge_t edges[POLYGON_EDGES];
+    uint8_t active[POLYGON_EDGES];
+    if (n<3 || n>POLYGON_EDGES)
+        return;
+    uint8_t ne=0;
+    int16_t ymin=points[1],ymax=points[1];
+    for (uint8_t i=0;i<n;i++) {
+        int16_t xa=points[2*i],ya=points[2*i+1];
+        uint8_t j=(i+1<n)?i+1:0;
+        int16_t xb=points[2*j],yb=points[2*j+1];
+        if (ya<ymin)
+            ymin=ya;
+        if (ya>ymax)
+            ymax=ya;
+        if (ya==yb)
+            continue;
+        // going down from a to b, y of the point after b on the next edge
+        // that is not horizontal, or going up, y of the point before a
+        int16_t ynext;
+        if (ya<yb) {
+            do {
+                uint8_t k=(j+1<n)?j+1:0;
+                ynext=points[2*k+1];
+                j=k;
+            } while (ynext==yb);
+        }
+        else {
+            uint8_t k=i;
+            do {
+                k=k?k-1:n-1;
+                ynext=points[2*k+1];
+            } while (ynext==ya);
+        }
+        edge_t *e=&edges[ne++];
+        if (ya<yb) {
+            e->ytop=ya;
+            e->ybot=yb-(ynext>yb);
+            e->x=((int32_t)xa<<16)+0x8000;
+            e->dx=(((int32_t)xb-xa)<<16)/(yb-ya);
+        }
+        else {
+            e->ytop=yb;
+            e->ybot=ya-(ynext>ya);
+            e->x=((int32_t)xb<<16)+0x8000;
+            e->dx=(((int32_t)xa-xb)<<16)/(ya-yb);
+        }
+    }
+    // edge table in order of top lines
+    for (uint8_t i=1;i<ne;i++) {
+        edge_t e=edges[i];
+        uint8_t j=i;
+        for (;j && edges[j-1].ytop>e.ytop;j--)
+            edges[j]=edges[j-1];
+        edges[j]=e;
+    }
+    if (ymin<0)
+        ymin=0;
+    if (ymax>height-1)
+        ymax=height-1;
+    uint8_t na=0;
+    uint8_t next=0;
+    int16_t sx1=0,sx2=-1,sy=0;  // span that repeats on lines from sy
+    for (int16_t y=ymin;y<=ymax;y++) {
+        uint8_t k=0;
+        for (uint8_t i=0;i<na;i++) {
+            if (edges[active[i]].ybot>=y)
+                active[k++]=active[i];
+        }
+        na=k;
+        for (;next<ne && edges[next].ytop<=y;next++) {
+            edge_t *e=&edges[next];
+            if (e->ybot<y)
+                continue;
+            e->x+=e->dx*(y-e->ytop);
+            active[na++]=next;
+        }
+        for (uint8_t i=1;i<na;i++) {
+            uint8_t a=active[i];
+            uint8_t j=i;
+            for (;j && edges[active[j-1]].x>edges[a].x;j--)
+                active[j]=active[j-1];
+            active[j]=a;
+        }
+        if (na==2) {
+            int16_t x1=edges[active[0]].x>>16;
+            int16_t x2=edges[active[1]].x>>16;
+            if (x1!=sx1 || x2!=sx2) {
+                if (sx1<=sx2)
+                    filled_rect(sx1,sy,sx2,y-1,color);
+                sx1=x1;
+                sx2=x2;
+                sy=y;
+            }
+        }
+        else {
+            if (sx1<=sx2)
+                filled_rect(sx1,sy,sx2,y-1,color);
+            sx1=0;
+            sx2=-1;
+            for (uint8_t i=0;i+1<na;i+=2)
+                hline(edges[active[i]].x>>16,y,edges[active[i+1]].x>>16,color);
+        }
+        for (uint8_t i=0;i<na;i++)
+            edges[active[i]].x+=edges[active[i]].dx;
+    }
+    if (sx1<=sx2)
+        filled_rect(sx1,sy,sx2,ymax,color);
+}
+
+template <class T>
+void VS23S010T<T>::fill_triangle(int16_t x1,int16_t y1,int16_t x2,int16_t y2,int16_t x3,int16_t y3,uint8_t color)
+{
+    int16_t points[6]={x1,y1,x2,y2,x3,y3};
+    fill_polygon(points,3,color);
+}
+
+// sine of 0..90 degrees, scaled to 255
+static uint8_t const sine90[] PROGMEM = {
+    0,  4,  9, 13, 18, 22, 27, 31, 35, 40, 44, 49, 53, 57, 62, 66,
+   70, 75, 79, 83, 87, 91, 96,100,104,108,112,116,120,124,127,131,
+  135,139,143,146,150,153,157,160,164,167,171,174,177,180,183,186,
+  190,192,195,198,201,204,206,209,211,214,216,219,221,223,225,227,
+  229,231,233,235,236,238,240,241,243,244,245,246,247,248,249,250,
+  251,252,253,253,254,254,254,255,255,255,255
+};
+
+// direction of angle in degrees, counterclockwise from 3 o'clock, as
+// cosine and sine scaled to 255. sine is positive upwards
+template <class T>
+void VS23S010T<T>::sector_dir(int16_t angle,int16_t &c,int16_t &s)
+{
+    angle%=360;
+    if (angle<0)
+        angle+=360;
+    uint8_t q=angle/90;
+    uint8_t a=angle%90;
+    int16_t sa=pgm_read_byte(&sine90[a]);
+    int16_t ca=pgm_read_byte(&sine90[90-a]);
+    switch (q) {
+        case 0: c=ca; s=sa; break;
+        case 1: c=-sa; s=ca; break;
+        case 2: c=-ca; s=-sa; break;
+        default: c=sa; s=-ca; break;
+    }
+}
+
+// narrows span x1..x2 on line qy (both relative to centre, qy upwards)
+// to points that are counterclockwise from direction c,s by up to half
+// circle, that is where c*qy-s*x>=0
+template <class T>
+void VS23S010T<T>::half_plane(int16_t c,int16_t s,int16_t qy,int16_t &x1,int16_t &x2)
+{
+    int32_t n=(int32_t)c*qy;
+    if (s>0) {
+        // x<=n/s, rounded down
+        int32_t lim=(n>=0)?n/s:-((-n+s-1)/s);
+        if (lim<x2)
+            x2=lim;
+    }
+    else if (s<0) {
+        // x>=n/s, rounded up
+        s=-s;
+        n=-n;
+        int32_t lim=(n>=0)?(n+s-1)/s:-((-n)/s);
+        if (lim>x1)
+            x1=lim;
+    }
+    else if (n<0)
+        x2=x1-1;
+}
+
+// draws span x1..x2 from centre xc on screen line y, that is line qy
+// from centre counting upwards. for arcs and pies the span is first
+// narrowed to the sector
+template <class T>
+void VS23S010T<T>::sector_span(int16_t xc,int16_t y,int16_t x1,int16_t x2,int16_t qy,uint8_t color,const sector_t *sector)
+{
+    if (y<0 || y>(height-1))
+        return;
+    if (!sector) {
+        hline(xc+x1,y,xc+x2,color);
+        return;
+    }
+    int16_t a1=x1,a2=x2;
+    half_plane(sector->c0,sector->s0,qy,a1,a2);
+    int16_t b1=x1,b2=x2;
+    half_plane(-sector->c1,-sector->s1,qy,b1,b2);
+    if (!sector->wide) {
+        // inside both half planes
+        if (b1>a1)
+            a1=b1;
+        if (b2<a2)
+            a2=b2;
+        if (a1<=a2)
+            hline(xc+a1,y,xc+a2,color);
+        return;
+    }
+    // in either half plane, drawn as one span if the parts touch
+    if (a1<=a2 && b1<=b2 && a1<=b2+1 && b1<=a2+1) {
+        hline(xc+((a1<b1)?a1:b1),y,xc+((a2>b2)?a2:b2),color);
+        return;
+    }
+    if (a1<=a2)
+        hline(xc+a1,y,xc+a2,color);
+    if (b1<=b2)
+        hline(xc+b1,y,xc+b2,color);
+}
+
+// midpoint ellipse, going down from centre line one line at a time and
+// keeping x on the edge for each. as the error term is kept relative
+// to the edge, it stays in 32 bits for radii up to 1000. a point is
+// inside when ry*ry*x*x+rx*rx*y*y<=rx*rx*ry*ry+rx*ry*min(rx,ry), for
+// circle x*x+y*y<=r*r+r, which gives rounder small circles than r*r.
+// lines are drawn as spans mirrored above and below the centre. for
+// outline the span on each side reaches from the edge to the edge of
+// next line, so the points of all octants on a line go out together
+template <class T>
+void VS23S010T<T>::ellipse_spans(int16_t xc,int16_t yc,uint16_t rx,uint16_t ry,bool fill,uint8_t color,const sector_t *sector)
+{
+    if (yc-(int32_t)ry>(height-1) || yc+(int32_t)ry<0 ||
+        xc-(int32_t)rx>(width-1) || xc+(int32_t)rx<0)
+        return;
+    int32_t rx2=(int32_t)rx*rx;
+    int32_t ry2=(int32_t)ry*ry;
+    int32_t err=-((int32_t)rx*ry*((rx<ry)?rx:ry));
+    int16_t x=rx;
+    int16_t w=x;
+    for (uint16_t dy=0;dy<=ry;dy++) {
+        int16_t next=-1;
+        if (dy<ry) {
+            err+=rx2*(2*dy+1);
+            while (err>0 && x>0) {
+                err-=ry2*(2*x-1);
+                x--;
+            }
+            next=x;
+        }
+        int16_t lo=fill?0:(next<w)?next+1:w;
+        for (uint8_t side=0;side<2;side++) {
+            int16_t y=side?yc+dy:yc-dy;
+            int16_t qy=side?-dy:dy;
+            if (lo==0)
+                sector_span(xc,y,-w,w,qy,color,sector);
+            else {
+                sector_span(xc,y,-w,-lo,qy,color,sector);
+                sector_span(xc,y,lo,w,qy,color,sector);
+            }
+            if (!dy)
+                break;
+        }
+        w=next;
+    }
+}
+
+template <class T>
+void VS23S010T<T>::circle(int16_t x,int16_t y,uint16_t r,uint8_t color)
+{
+    ellipse_spans(x,y,r,r,false,color,NULL);
+}
+
+template <class T>
+void VS23S010T<T>::filled_circle(int16_t x,int16_t y,uint16_t r,uint8_t color)
+{
+    ellipse_spans(x,y,r,r,true,color,NULL);
+}
+
+template <class T>
+void VS23S010T<T>::ellipse(int16_t x,int16_t y,uint16_t rx,uint16_t ry,uint8_t color)
+{
+    ellipse_spans(x,y,rx,ry,false,color,NULL);
+}
+
+template <class T>
+void VS23S010T<T>::filled_ellipse(int16_t x,int16_t y,uint16_t rx,uint16_t ry,uint8_t color)
+{
+    ellipse_spans(x,y,rx,ry,true,color,NULL);
+}
+
+// part of circle outline, or filled pie segment, going counterclockwise
+// from start to end angle in degrees, 0 being at 3 o'clock. sectors of
+// 360 degrees or more are whole circles
+template <class T>
+void VS23S010T<T>::sector(int16_t x,int16_t y,uint16_t r,int16_t start,int16_t end,bool fill,uint8_t color)
+{
+    int16_t span=end-start;
+    if (span>=360 || span<=-360) {
+        ellipse_spans(x,y,r,r,fill,color,NULL);
+        return;
+    }
+    span%=360;
+    if (span<0)
+        span+=360;
+    if (!span)
+        return;
+    sector_t s;
+    sector_dir(start,s.c0,s.s0);
+    sector_dir(end,s.c1,s.s1);
+    s.wide=span>180;
+    ellipse_spans(x,y,r,r,fill,color,&s);
+}
+
+template <class T>
+void VS23S010T<T>::arc(int16_t x,int16_t y,uint16_t r,int16_t start,int16_t end,uint8_t color)
+{
+    sector(x,y,r,start,end,false,color);
+}
+
+template <class T>
+void VS23S010T<T>::pie(int16_t x,int16_t y,uint16_t r,int16_t start,int16_t end,uint8_t color)
+{
+    sector(x,y,r,start,end,true,color);
+}
+
+// this looks up the width of given character in pixels from given font
+// of font does not have the character defined, then a 0 width is returned
+template <class T>
+uint8_t VS23S010T<T>::char_width(uint8_t c,const FONT* font)
+{
+    if ((!font) || (c<font->firstchar) || (c>font->lastchar)) {
+        return 0;
+    }
+    c-=font->firstchar;
+    return (font->width)?font->width:pgm_read_byte(&font->widths_P[c]);
+}
+
+// this draws a character from font data that is in flash memory
+// to screen at specified location. x,y are coordinates of top left
+// corner of character cell. current foreground and background colors
+// are used, if the background color is set the same as foreground then
+// background pixels are not drawn, preserving existing background.
+template <class T>
+int16_t VS23S010T<T>::blitchar(uint8_t c,int16_t x,int16_t y,const FONT* font)
+{
+    if ((!font) || (c<font->firstchar) || (c>font->lastchar)) {
+        return x;
+    }
+    uint8_t w=char_width(c,font);
+    if (!w)
+        return x;
+    c-=font->firstchar;
+    uint8_t h=font->height;
+    const uint8_t *bits_P;
+    if (font->width)
+        bits_P=&(font->bitmaps_P[0][(((w+7)>>3)*(uint16_t)h*(uint16_t)c)]);
+    else
+        bits_P=font->bitmaps_P[c];
+    draw_bits(x,y,w,h,bits_P,1,NULL,true);
+    return x+w;
+}
+
+// draw w*h pixel image from RAM at x,y. rows start at byte boundary, 1
+// bit per pixel images are drawn with current colors, transparent if they
+// are the same. 4 bit pixels are looked up from palette of 16 colors, or
+// used as they are if there is no palette, and 8 bit pixels are colors.
+// first pixel is in high bits of byte
+template <class T>
+void VS23S010T<T>::draw_bitmap(int16_t x,int16_t y,uint16_t w,uint16_t h,const uint8_t *bits,uint8_t bpp,const uint8_t *palette)
+{
+    draw_bits(x,y,w,h,bits,bpp,palette,false);
+}
+
+// same for image in flash, palette is in RAM
+template <class T>
+void VS23S010T<T>::draw_bitmap_P(int16_t x,int16_t y,uint16_t w,uint16_t h,const uint8_t *bits_P,uint8_t bpp,const uint8_t *palette)
+{
+    draw_bits(x,y,w,h,bits_P,bpp,palette,true);
+}
+
+// each image line is written in one go, clipped to screen. for
+// transparent 1 bit images the line is split into runs of set pixels and
+// each run is filled with a single burst
+template <class T>
+void VS23S010T<T>::draw_bits(int16_t x,int16_t y,uint16_t w,uint16_t h,const uint8_t *bits,uint8_t bpp,const uint8_t *palette,bool flash)
+{
+    if (bpp!=1 && bpp!=4 && bpp!=8)
+        return;
+    uint16_t bpl=((uint32_t)w*bpp+7)>>3;
+    // visible columns of the image
+    uint16_t first=(x<0)?(((uint16_t)-x<w)?-x:w):0;
+    uint16_t last=(x+(int32_t)w>width)?((x<width)?width-x:0):w;
+    if (first>=last)
+        return;
+    if (y<0) {
+        if ((uint16_t)-y>=h)
+            return;
+        bits+=(uint32_t)bpl*-y;
+        h+=y;
+        y=0;
+    }
+    bool transparent=(bpp==1 && fgcolor==bgcolor);
+    for (;h && y<height;h--,y++,bits+=bpl) {
+        uint32_t addr=line_address(y)+x;
+        if (transparent) {
+            uint16_t i=first;
+            while (i<last) {
+                while (i<last && !(bits_byte(bits+(i>>3),flash)&(0x80>>(i&7))))
+                    i++;
+                uint16_t j=i;
+                while (j<last && (bits_byte(bits+(j>>3),flash)&(0x80>>(j&7))))
+                    j++;
+                if (j>i)
+                    mem_fill(addr+i,fgcolor,j-i);
+                i=j;
+            }
+            continue;
+        }
+        uint8_t pixels[16];
+        uint8_t n=0;
+        mem_select(WRITE,addr+first);
+        for (uint16_t i=first;i<last;i++) {
+            uint8_t b;
+            if (bpp==1)
+                b=(bits_byte(bits+(i>>3),flash)&(0x80>>(i&7)))?fgcolor:bgcolor;
+            else if (bpp==4) {
+                b=bits_byte(bits+(i>>1),flash);
+                b=(i&1)?(b&15):(b>>4);
+                if (palette)
+                    b=palette[b];
+            }
+            else
+                b=bits_byte(bits+i,flash);
+            pixels[n++]=b;
+            if (n==sizeof(pixels)) {
+                bus().spi_write(pixels,n);
+                n=0;
+            }
+        }
+        bus().spi_write(pixels,n);
+        select(false);
+    }
+}
+
+// this draws a character from currently set font to specified
+// screen location, using harware block move function. characters that
+// are narrower than the block mover can do, or are not fully on screen,
+// are drawn with blitchar() instead
+template <class T>
+int16_t VS23S010T<T>::vblitchar(uint8_t c,int16_t x,int16_t y)
+{
+    if ((c<current_font->firstchar) || (c>current_font->lastchar)) {
+        return x;
+    }
+    fontslot_t *f=&fontslots[font_slot()];
+    uint8_t w=char_width(c,current_font);
+    c-=current_font->firstchar;
+    if (!w)
+        return x;
+    uint32_t src=glyph_address(f,c);
+    uint8_t h=current_font->height;
+    // characters cut by screen edges are clipped by blitchar()
+    if (!src || w<blitminw || x<0 || x+w>width || y<0 || y+h>height)
+        return blitchar(c+current_font->firstchar,x,y,current_font);
+    // glyphs are rendered with slot colors when first used
+    if (!(f->rendered[c>>3]&(1<<(c&7)))) {
+        render_glyph(c,w,src);
+        f->rendered[c>>3]|=1<<(c&7);
+    }
+    // with ring scrolling the character may need to be split in two
+    // where the picture lines wrap around
+    int16_t n=lines_to_wrap(y);
+    uint32_t dst=line_address(y)+x;
+    if (n<h) {
+        blitter_op(src, w, n, dst, 0);
+        src+=(uint32_t)linesize*n;
+        dst=line_address(y+n)+x;
+        h-=n;
+    }
+    blitter_op(src, w, h, dst, 0);
+    return x+w;
+}
+
+// fonts are kept in video memory past the last visible screen line,
+// each rendition of a font in the colors it is used with in a slot of its
+// own, up to FONTSLOTS of them. selecting a font only makes it current,
+// the slot for it is found when text is drawn with it
+template <class T>
+void VS23S010T<T>::set_font(const FONT* font)
+{
+    if (font)
+        current_font=font;
+    else
+        current_font=&emptyfont;
+    font_slot();
+}
+
+// selects font of the atlas and writes all its glyphs into video memory
+// at once, line by line as they are laid out in atlas. this is quicker
+// than rendering them one by one from font bitmaps. atlas made for
+// bitmap area of different width is not used, glyphs of the font are
+// then rendered on first use as usual. when the font is already in a slot
+// in current colors it is only selected. returns false if not all glyphs
+// of the font are in video memory, because the atlas did not match the
+// layout or there was no room for all of it
+template <class T>
+bool VS23S010T<T>::set_font(const FONTATLAS* atlas)
+{
+    if (!atlas) {
+        set_font((const FONT*)NULL);
+        return false;
+    }
+    // slot that is already there keeps its glyphs
+    current_font=atlas->font;
+    bool resident=(font_find()<FONTSLOTS);
+    set_font(atlas->font);
+    fontslot_t *f=&fontslots[fontslot];
+    uint16_t cc=((uint16_t)current_font->lastchar-current_font->firstchar+1);
+    if (resident) {
+        for (uint16_t c=0;c<cc;c++) {
+            if (!(f->rendered[c>>3]&(1<<(c&7))))
+                return false;
+        }
+        return true;
+    }
+    if (!f->cells || atlas->cellw!=f->cellw || atlas->cells!=f->cells ||
+        atlas->rows!=(cc+f->cells-1)/f->cells)
+        return false;
+    uint8_t h=current_font->height;
+    uint16_t lines=atlas->rows*h;
+    if (lines>f->lines)
+        lines=f->lines;
+    uint16_t bytes=((uint16_t)atlas->cellw*atlas->cells+7)>>3;
+    uint16_t atlasw=(uint16_t)atlas->cellw*atlas->cells;
+    const uint8_t *p=atlas->atlas_P;
+    uint8_t run=0;      // bytes left in PackBits run
+    bool repeat=false;
+    uint8_t v=0;        // byte that is repeated
+    uint32_t addr=vmemchars;
+    for (uint16_t line=0;line<lines;line++) {
+        uint8_t pixels[16];
+        uint8_t n=0;
+        uint16_t x=0;
+        mem_select(WRITE,addr);
+        for (uint16_t i=0;i<bytes;i++) {
+            uint8_t b;
+            if (!atlas->packed)
+                b=pgm_read_byte(p++);
+            else {
+                if (!run) {
+                    int8_t hdr=pgm_read_byte(p++);
+                    repeat=(hdr<0);
+                    run=repeat?1-hdr:hdr+1;
+                    if (repeat)
+                        v=pgm_read_byte(p++);
+                }
+                b=repeat?v:pgm_read_byte(p++);
+                run--;
+            }
+            for (uint8_t j=0;j<8 && x<atlasw;j++,x++) {
+                pixels[n++]=(b&0x80)?fgcolor:bgcolor;
+                b<<=1;
+                if (n==sizeof(pixels)) {
+                    bus().spi_write(pixels,n);
+                    n=0;
+                }
+            }
+        }
+        bus().spi_write(pixels,n);
+        select(false);
+        addr+=linesize;
+    }
+    // glyphs in the rows written are all there now
+    uint16_t loaded=(lines/h)*atlas->cells;
+    if (loaded>cc)
+        loaded=cc;
+    for (uint16_t c=0;c<loaded;c++)
+        f->rendered[c>>3]|=1<<(c&7);
+    return loaded==cc;
+}
+
+// slot of current font in current colors. a slot that is not there
+// gets a free band of lines in bitmap area, glyphs are rendered into it
+// on first use. if there is no room then
+// least recently selected slots are thrown out until there is
+template <class T>
+uint8_t VS23S010T<T>::font_slot()
+{
+    fontslot_t *f;
+    if (fontslot<FONTSLOTS) {
+        f=&fontslots[fontslot];
+        if (f->font==current_font && f->fg==fgcolor && f->bg==bgcolor)
+            return fontslot;
+    }
+    uint8_t s=font_find();
+    if (s==FONTSLOTS)
+        s=load_font();
+    fontslot=s;
+    fontslots[s].used=++fontclock;
+    vmemchars=vmem_address(fontslots[s].line);
+    return s;
+}
+
+// slot that has current font in current colors, FONTSLOTS if none
+template <class T>
+uint8_t VS23S010T<T>::font_find()
+{
+    uint8_t s;
+    for (s=0;s<FONTSLOTS;s++) {
+        fontslot_t *f=&fontslots[s];
+        if (f->font==current_font && f->fg==fgcolor && f->bg==bgcolor)
+            break;
+    }
+    return s;
+}
+
+// least recently selected font slot. unused slots are taken first unless
+// only loaded ones are asked for, FONTSLOTS if there is no such slot
+template <class T>
+uint8_t VS23S010T<T>::font_lru(bool loaded)
+{
+    uint8_t lru=FONTSLOTS;
+    for (uint8_t s=0;s<FONTSLOTS;s++) {
+        if (!fontslots[s].font) {
+            if (!loaded)
+                return s;
+            continue;
+        }
+        if (lru==FONTSLOTS || (uint16_t)(fontclock-fontslots[s].used)>
+            (uint16_t)(fontclock-fontslots[lru].used))
+            lru=s;
+    }
+    return lru;
+}
+
+// throw font out of video memory
+template <class T>
+void VS23S010T<T>::font_free(uint8_t s)
+{
+    fontslot_t *f=&fontslots[s];
+    if (!f->font)
+        return;
+    // moves from its glyphs can still be pending
+    blit_flush();
+    f->font=NULL;
+    vmem_free(f->line,f->lines);
+}
+
+// this sets up slot for current font in current colors. glyphs will be
+// pre-rendered with the colors (no transparency here, block mover cannot
+// do it). block mover also needs the characters the same as whay would be
+// rendered on screen, scattered across sequential "screen lines", so the
+// glyphs are laid out in rows of cells as wide as the widest character,
+// as many rows as fit in the bitmap area. this way the place of each
+// glyph can be worked out from its number, without keeping a table of
+// offsets. once the font is set up this way, the accelerated vblitchar
+// can be used to copy these invisible character cells to visible screen,
+// and it is much faster that doing to pixel by pixel. returns the slot
+// the font was loaded to
+template <class T>
+uint8_t VS23S010T<T>::load_font()
+{
+    const FONT *font=current_font;
+    uint8_t h=font->height;
+    uint16_t cc=((uint16_t)font->lastchar-font->firstchar+1);
+    uint8_t cellw=font->width;
+    if (!cellw) {
+        for (uint16_t i=0;i<cc;i++) {
+            uint8_t w=pgm_read_byte(&font->widths_P[i]);
+            if (w>cellw)
+                cellw=w;
+        }
+    }
+    // cells wider than bitmap area leave none on a row
+    uint16_t n=cellw?BITMAP_WIDTH/cellw:0;
+    uint8_t cells=(n>255)?255:n;
+    uint16_t rows=cells?(cc+cells-1)/cells:0;
+    if (h && rows>BITMAP_LINES/h)
+        rows=BITMAP_LINES/h;
+    uint16_t lines=rows*h;
+    uint8_t slot=font_lru(false);
+    font_free(slot);
+    // without room the glyphs are drawn from flash
+    int16_t line=vmem_alloc(lines);
+    if (line<0) {
+        line=0;
+        lines=0;
+    }
+    fontslot_t *f=&fontslots[slot];
+    f->font=font;
+    f->fg=fgcolor;
+    f->bg=bgcolor;
+    f->line=line;
+    f->lines=lines;
+    f->cellw=cellw;
+    f->cells=cells;
+    for (uint8_t i=0;i<sizeof(f->rendered);i++)
+        f->rendered[i]=0;
+    return slot;
+}
+
+// address of glyph of character c (counted from first character of font)
+// in font slot, 0 if the glyph did not fit in bitmap area
+template <class T>
+uint32_t VS23S010T<T>::glyph_address(const fontslot_t *f,uint8_t c)
+{
+    if (!f->cells)
+        return 0;
+    uint8_t h=f->font->height;
+    uint16_t row=c/f->cells;
+    if ((row+1)*h>f->lines)
+        return 0;
+    return vmem_address(f->line+row*h)+(uint16_t)(c%f->cells)*f->cellw;
+}
+
+// expand bitmap of character c (counted from first character of font)
+// into pixel image past visible area in vram with correct line skip values
+// so that blitter can be used to copy it to screen. each character line is
+// expanded to buffer first and then written out in one go, the characters
+// are limited to 32 pixels wide
+template <class T>
+void VS23S010T<T>::render_glyph(uint8_t c,uint8_t w,uint32_t addr)
+{
+    const FONT *font=current_font;
+    uint8_t h=font->height;
+    // make pointer to bitmap of character data
+    const uint8_t *bits_P;
+    if (font->width)
+        bits_P=&(font->bitmaps_P[0][(((w+7)>>3)*(uint16_t)h*c)]);
+    else
+        bits_P=font->bitmaps_P[c];
+    uint8_t pixels[32];
+    while (h--) {
+        uint8_t bit=0;
+        uint8_t b=0;
+        for (uint8_t j=0;j<w;j++) {
+            if (!bit) {
+                b=pgm_read_byte(bits_P);
+                bits_P++;
+                bit=8;
+            }
+            pixels[j]=(b&0x80)?fgcolor:bgcolor;
+            b<<=1;
+            bit--;
+        }
+        mem_write(addr,pixels,w);
+        addr+=linesize;
+    }
+}
+
+// elementary teletype style terminal, just
+// knows how to go to start of line and next line
+// just a primitive beginning for now
+template <class T>
+int16_t VS23S010T<T>::putc(uint8_t c)
+{
+    switch (c) {
+        case 10:
+            cursory+=current_font->height;
+            return cursorx;
+        case 13:
+            cursorx=0;
+            return cursorx;
+    }
+    if ((c<current_font->firstchar) || (c>current_font->lastchar))
+        cursorx=blitchar(emptyfont.firstchar,cursorx,cursory,&emptyfont);
+    else {
+        if (vmemchars && fgcolor!=bgcolor)
+            cursorx=vblitchar(c,cursorx,cursory);
+        else
+            cursorx=blitchar(c,cursorx,cursory,current_font);
+    }
+    return cursorx;
+}
+
+// two different versions of string output here. did you also notice the
+// pgm_read_byte() calls above? Thank the geniuses who thought pure 
+// Harward architecture was a brilliant idea. Look it up on Google, and
+// you'll get this - "It is modern computer architecture based on Harvard 
+// Mark I relay based model." Very modern indeed, you cannot even access
+// your data with the same instructions in flash and ram
+//
+template <class T>
+int16_t VS23S010T<T>::puts(char *s)
+{
+    return puts((const char*)s);
+}
+
+// text between line breaks is drawn with text_run() when the font
+// is in video memory and can be block moved
+template <class T>
+int16_t VS23S010T<T>::puts(const char *s)
+{
+    while (s && *s) {
+        if (*s==10 || *s==13 || !vmemchars || fgcolor==bgcolor)
+            putc(*s++);
+        else
+            s=text_run(s);
+    }
+    return cursorx;
+}
+
+// draws characters from s up to end of string or line break at cursor
+// position. where glyphs go and how they are clipped is worked out from
+// font data in flash and the layout of font slot, so nothing is read
+// back from video memory. glyphs not rendered yet are rendered first, then
+// the moves are queued back to back, each one being loaded into the
+// shadow registers while the previous one is still running. characters
+// cut by screen edge, too narrow for block mover or not fitting in video
+// memory are drawn from flash instead. returns pointer to the first
+// character not drawn
+template <class T>
+const char* VS23S010T<T>::text_run(const char *s)
+{
+    const FONT *font=current_font;
+    fontslot_t *f=&fontslots[font_slot()];
+    const char *e;
+    for (e=s;*e && *e!=10 && *e!=13;e++) {
+        uint8_t c=*e;
+        if ((c<font->firstchar) || (c>font->lastchar))
+            continue;
+        c-=font->firstchar;
+        if (!(f->rendered[c>>3]&(1<<(c&7)))) {
+            uint32_t src=glyph_address(f,c);
+            if (src)
+                render_glyph(c,char_width(c+font->firstchar,font),src);
+            f->rendered[c>>3]|=1<<(c&7);
+        }
+    }
+    // visible glyph lines, and where they go on screen. with ring
+    // scrolling they may need to be split in two where picture lines wrap
+    int16_t y=cursory;
+    uint8_t h=font->height;
+    uint8_t skip=0;
+    if (y<0) {
+        skip=(-y<h)?-y:h;
+        h-=skip;
+        y=0;
+    }
+    if (y+h>height)
+        h=(y<height)?height-y:0;
+    uint8_t n=h;
+    uint32_t dst1=0,dst2=0;
+    if (h) {
+        if (lines_to_wrap(y)<h)
+            n=lines_to_wrap(y);
+        dst1=line_address(y);
+        if (n<h)
+            dst2=line_address(y+n);
+    }
+    int16_t x=cursorx;
+    for (;s<e;s++) {
+        uint8_t c=*s;
+        if ((c<font->firstchar) || (c>font->lastchar)) {
+            x=blitchar(emptyfont.firstchar,x,cursory,&emptyfont);
+            continue;
+        }
+        uint8_t w=char_width(c,font);
+        if (!h || !w || x+w<=0 || x>=width) {
+            x+=w;
+            continue;
+        }
+        uint32_t src=glyph_address(f,c-font->firstchar);
+        if (src && w>=blitminw && x>=0 && x+w<=width) {
+            src+=(uint32_t)linesize*skip;
+            blit_queue(src,w,n,dst1+x,0);
+            if (n<h)
+                blit_queue(src+(uint32_t)linesize*n,w,h-n,dst2+x,0);
+        }
+        else
+            blitchar(c,x,cursory,font);
+        x+=w;
+    }
+    while (blit_drain())
+        ;
+    cursorx=x;
+    return e;
+}
+
+template <class T>
+int16_t VS23S010T<T>::printn(int32_t n)
+{
+    if (n<0) {
+        putc('-');  
+        n=0-n;
+    }
+    if (n>9)
+        printn(n/10);
+    return putc((n%10)+'0');
+}
+
+
+// moves n whole screen lines from ys to yd, in columns that the block
+// mover can do. where it can move overlapping areas, the lines go in
+// moves of up to 255 lines, split where the source or destination picture
+// lines wrap around, top down when moving up and bottom up with backwards
+// moves when moving down. otherwise every line is moved separately
+template <class T>
+void VS23S010T<T>::move_lines(int16_t ys,int16_t yd,int16_t n)
+{
+    const uint8_t columns=(width+254)/255;
+    bool down=(yd>ys);
+    while (n>0) {
+        int16_t k=n;
+        int16_t ls=down?ys+n-1:ys;
+        int16_t ld=down?yd+n-1:yd;
+        if (!(blitcaps&BLIT_OVERLAP))
+            k=1;
+        else if (!down) {
+            if (k>lines_to_wrap(ls))
+                k=lines_to_wrap(ls);
+            if (k>lines_to_wrap(ld))
+                k=lines_to_wrap(ld);
+        }
+        else {
+            // lines that are sequential up to the last ones
+            int16_t m=height-lines_to_wrap(ls)+1;
+            if (k>m)
+                k=m;
+            m=height-lines_to_wrap(ld)+1;
+            if (k>m)
+                k=m;
+        }
+        if (k>255)
+            k=255;
+        uint32_t src=line_address(ls);
+        uint32_t dst=line_address(ld);
+        for (uint8_t c=0;c<columns;c++) {
+            int16_t cx=(int16_t)((int32_t)width*c/columns);
+            uint8_t cw=(int16_t)((int32_t)width*(c+1)/columns)-cx;
+            if (down)
+                blitter_op(src+cx+cw-1,cw,k,dst+cx+cw-1,1);
+            else
+                blitter_op(src+cx,cw,k,dst+cx,0);
+        }
+        if (!down) {
+            ys+=k;
+            yd+=k;
+        }
+        n-=k;
+    }
+}
+
+// scrolling moves the lines that stay on screen with move_lines()
+// in ring scrolling mode no pixel data is moved at all, the lines that
+// scroll out are cleared and the line indexes are rotated so that these
+// become the new lines on the other side of the screen.
+
+template <class T>
+void VS23S010T<T>::scroll_up(int16_t lines)
+{
+    if (lines<=0)
+        return;
+    if (lines>=height) {
+        filled_rect(0,0,width-1,height-1,bgcolor);
+        return;
+    }
+    if (ringscroll) {
+        filled_rect(0,0,width-1,lines-1,bgcolor);
+        topline[drawpage]+=lines;
+        if (topline[drawpage]>=height)
+            topline[drawpage]-=height;
+        forget_line_address();
+        set_picture_indexes();
+        return;
+    }
+    move_lines(lines,0,height-lines);
+    filled_rect(0,height-lines,width-1,height-1,bgcolor);
+}
+
+template <class T>
+void VS23S010T<T>::scroll_down(int16_t lines)
+{
+    if (lines<=0)
+        return;
+    if (lines>=height) {
+        filled_rect(0,0,width-1,height-1,bgcolor);
+        return;
+    }
+    if (ringscroll) {
+        filled_rect(0,height-lines,width-1,height-1,bgcolor);
+        topline[drawpage]-=lines;
+        if (topline[drawpage]<0)
+            topline[drawpage]+=height;
+        forget_line_address();
+        set_picture_indexes();
+        return;
+    }
+    move_lines(0,lines,height-lines);
+    filled_rect(0,0,width-1,lines-1,bgcolor);
+}
+
+// queue a move between w by h area of screen at x,y and area in video
+// memory past the picture, saving the screen there or copying it back.
+// the screen area must be visible. with ring scrolling it may need to be
+// split in two where the picture lines wrap around. areas narrower than
+// block mover can do are copied right away with soft_move()
+template <class T>
+void VS23S010T<T>::offscreen_copy(uint32_t area,int16_t x,int16_t y,uint8_t w,uint8_t h,bool save)
+{
+    while (h) {
+        int16_t n=lines_to_wrap(y);
+        if (n>h)
+            n=h;
+        uint32_t scr=line_address(y)+x;
+        if (w<blitminw) {
+            blit_flush();
+            for (int16_t i=0;i<n;i++) {
+                if (save)
+                    soft_move(scr,w,1,area,0);
+                else
+                    soft_move(area,w,1,scr,0);
+                scr=next_line(scr);
+                area+=linesize;
+            }
+        }
+        else {
+            if (save)
+                blit_queue(scr,w,n,area,0);
+            else
+                blit_queue(area,w,n,scr,0);
+            area+=(uint32_t)linesize*n;
+        }
+        y+=n;
+        h-=n;
+    }
+}
+
+// address of image of sprite s in video memory, the screen saved under
+// it is right of it. the band for sprites is allocated on first use,
+// returns 0 if there is no room
+template <class T>
+uint32_t VS23S010T<T>::sprite_address(uint8_t s)
+{
+    if (spriteband<0)
+        spriteband=vmem_alloc(SPRITE_LINES);
+    if (spriteband<0)
+        return 0;
+    return vmem_address(spriteband+(s/SPRITE_CELLS)*SPRITE_SIZE)+
+        (s%SPRITE_CELLS)*2*SPRITE_SIZE;
+}
+
+// set image of sprite from flash, w*h pixels row by row. sprite that is
+// shown is drawn again with the new image
+template <class T>
+void VS23S010T<T>::sprite_image(uint8_t s,uint8_t w,uint8_t h,const uint8_t *pixels_P)
+{
+    if (s>=SPRITES)
+        return;
+    sprite_t *p=&sprites[s];
+    bool shown=p->shown;
+    sprite_hide(s);
+    blit_flush();
+    p->w=(w<SPRITE_SIZE)?w:SPRITE_SIZE;
+    p->h=(h<SPRITE_SIZE)?h:SPRITE_SIZE;
+    uint32_t addr=sprite_address(s);
+    if (!addr) {
+        p->w=0;
+        return;
+    }
+    for (uint8_t y=0;y<p->h;y++) {
+        uint8_t pixels[16];
+        uint8_t n=0;
+        mem_select(WRITE,addr);
+        for (uint8_t x=0;x<p->w;x++) {
+            pixels[n++]=pgm_read_byte(pixels_P+x);
+            if (n==sizeof(pixels)) {
+                bus().spi_write(pixels,n);
+                n=0;
+            }
+        }
+        bus().spi_write(pixels,n);
+        select(false);
+        pixels_P+=w;
+        addr+=linesize;
+    }
+    if (shown)
+        sprite_move(s,p->x,p->y);
+}
+
+// set image of sprite from w*h area of screen at x,y, so that sprites
+// can be drawn with the drawing primitives. the area is clipped to
+// screen
+template <class T>
+void VS23S010T<T>::sprite_grab(uint8_t s,int16_t x,int16_t y,uint8_t w,uint8_t h)
+{
+    if (s>=SPRITES)
+        return;
+    sprite_t *p=&sprites[s];
+    sprite_hide(s);
+    if (w>SPRITE_SIZE)
+        w=SPRITE_SIZE;
+    if (h>SPRITE_SIZE)
+        h=SPRITE_SIZE;
+    int16_t x2=x+w;
+    int16_t y2=y+h;
+    if (x<0)
+        x=0;
+    if (y<0)
+        y=0;
+    if (x2>width)
+        x2=width;
+    if (y2>height)
+        y2=height;
+    p->w=0;
+    if (x>=x2 || y>=y2)
+        return;
+    uint32_t addr=sprite_address(s);
+    if (!addr)
+        return;
+    p->w=x2-x;
+    p->h=y2-y;
+    offscreen_copy(addr,x,y,p->w,p->h,true);
+    while (blit_drain())
+        ;
+}
+
+// move sprite to x,y and show it. the screen under the old position is
+// put back, the screen under new one saved, and the sprite drawn, each
+// one is a block move, or two where ring scrolled lines wrap around
+template <class T>
+void VS23S010T<T>::sprite_move(uint8_t s,int16_t x,int16_t y)
+{
+    if (s>=SPRITES)
+        return;
+    sprite_t *p=&sprites[s];
+    if (!p->w)
+        return;
+    uint32_t area=sprite_address(s);
+    if (p->shown)
+        offscreen_copy(area+SPRITE_SIZE,p->sx,p->sy,p->sw,p->sh,false);
+    p->shown=false;
+    p->x=x;
+    p->y=y;
+    int16_t x1=(x<0)?0:x;
+    int16_t y1=(y<0)?0:y;
+    int16_t x2=(x+p->w>width)?width:x+p->w;
+    int16_t y2=(y+p->h>height)?height:y+p->h;
+    if (x1<x2 && y1<y2) {
+        p->sx=x1;
+        p->sy=y1;
+        p->sw=x2-x1;
+        p->sh=y2-y1;
+        p->shown=true;
+        offscreen_copy(area+SPRITE_SIZE,x1,y1,p->sw,p->sh,true);
+        offscreen_copy(area+(uint32_t)linesize*(y1-y)+(x1-x),x1,y1,p->sw,p->sh,false);
+    }
+    while (blit_drain())
+        ;
+}
+
+// remove sprite from screen, putting back what was under it
+template <class T>
+void VS23S010T<T>::sprite_hide(uint8_t s)
+{
+    if (s>=SPRITES)
+        return;
+    sprite_t *p=&sprites[s];
+    if (p->shown)
+        offscreen_copy(sprite_address(s)+SPRITE_SIZE,p->sx,p->sy,p->sw,p->sh,false);
+    p->shown=false;
+    while (blit_drain())
+        ;
+}
+
+// set up tile map layer of cols*rows cells of w by h pixels at x,y on
+// screen. all cells are marked changed, nothing is drawn until update.
+// lines for tile images are allocated when the map is set up the first
+// time, and given back when it is set to NULL
+template <class T>
+void VS23S010T<T>::tile_map(uint8_t *map,uint8_t cols,uint8_t rows,uint8_t w,uint8_t h,int16_t x,int16_t y)
+{
+    tilemap=map;
+    tilecols=cols;
+    tilerows=rows;
+    tilew=w;
+    tileh=h;
+    tilex=x;
+    tiley=y;
+    // tiles wider than bitmap area leave none on a row
+    uint16_t n=w?BITMAP_WIDTH/w:0;
+    tilecells=(n>255)?255:n;
+    if (!map) {
+        if (tileband>=0)
+            vmem_free(tileband,TILE_LINES);
+        tileband=-1;
+        return;
+    }
+    if (tileband<0)
+        tileband=vmem_alloc(TILE_LINES);
+    for (uint16_t i=0;i<(uint16_t)cols*rows;i++)
+        map[i]|=TILE_DIRTY;
+}
+
+// address of image of tile t in video memory, 0 if it does not fit
+template <class T>
+uint32_t VS23S010T<T>::tile_address(uint8_t t)
+{
+    if (!tilecells || tileband<0)
+        return 0;
+    uint8_t row=t/tilecells;
+    if ((uint16_t)(row+1)*tileh>TILE_LINES)
+        return 0;
+    return vmem_address(tileband+row*tileh)+(uint16_t)(t%tilecells)*tilew;
+}
+
+// set image of tile from flash, w*h pixels row by row in size given
+// for tile map
+template <class T>
+void VS23S010T<T>::tile_image(uint8_t t,const uint8_t *pixels_P)
+{
+    uint32_t addr=tile_address(t);
+    if (!addr)
+        return;
+    blit_flush();
+    for (uint8_t y=0;y<tileh;y++) {
+        uint8_t pixels[16];
+        uint8_t n=0;
+        mem_select(WRITE,addr);
+        for (uint8_t x=0;x<tilew;x++) {
+            pixels[n++]=pgm_read_byte(pixels_P++);
+            if (n==sizeof(pixels)) {
+                bus().spi_write(pixels,n);
+                n=0;
+            }
+        }
+        bus().spi_write(pixels,n);
+        select(false);
+        addr+=linesize;
+    }
+}
+
+// set image of tile from screen area at x,y, which must be visible
+template <class T>
+void VS23S010T<T>::tile_grab(uint8_t t,int16_t x,int16_t y)
+{
+    uint32_t addr=tile_address(t);
+    if (!addr || x<0 || y<0 || x+tilew>width || y+tileh>height)
+        return;
+    offscreen_copy(addr,x,y,tilew,tileh,true);
+    blit_flush();
+}
+
+// put tile t to cell col,row, the cell is drawn on next update if the
+// tile changes
+template <class T>
+void VS23S010T<T>::tile_set(uint8_t col,uint8_t row,uint8_t t)
+{
+    if (!tilemap || col>=tilecols || row>=tilerows)
+        return;
+    uint8_t *m=&tilemap[(uint16_t)row*tilecols+col];
+    t&=~TILE_DIRTY;
+    if ((*m&~TILE_DIRTY)!=t)
+        *m=t|TILE_DIRTY;
+}
+
+// draw cells of tile map that have changed, one block move for each cell,
+// queued back to back. cells cut by screen edge are clipped
+template <class T>
+void VS23S010T<T>::tile_update()
+{
+    if (!tilemap)
+        return;
+    uint8_t *m=tilemap;
+    int16_t y=tiley;
+    for (uint8_t row=0;row<tilerows;row++,y+=tileh) {
+        // visible lines of the row of cells
+        int16_t y1=(y<0)?0:y;
+        int16_t y2=(y+tileh>height)?height:y+tileh;
+        int16_t x=tilex;
+        for (uint8_t col=0;col<tilecols;col++,m++,x+=tilew) {
+            if (!(*m&TILE_DIRTY))
+                continue;
+            *m&=~TILE_DIRTY;
+            uint32_t src=tile_address(*m);
+            int16_t x1=(x<0)?0:x;
+            int16_t x2=(x+tilew>width)?width:x+tilew;
+            if (!src || x1>=x2 || y1>=y2)
+                continue;
+            src+=(uint32_t)linesize*(y1-y)+(x1-x);
+            offscreen_copy(src,x1,y1,x2-x1,y2-y1,false);
+        }
+    }
+    while (blit_drain())
+        ;
+}
+
+// first fit allocation from the free bands. fonts are only a cache, these
+// are thrown out when there is no room. empty band is not a band
+template <class T>
+int16_t VS23S010T<T>::vmem_alloc(uint16_t lines)
+{
+    if (!lines)
+        return -1;
+    while (1) {
+        for (uint8_t i=0;i<vfreecount;i++) {
+            vband_t *b=&vfree[i];
+            if (b->lines<lines)
+                continue;
+            int16_t line=b->line;
+            b->line+=lines;
+            b->lines-=lines;
+            if (!b->lines) {
+                vfreecount--;
+                for (;i<vfreecount;i++)
+                    vfree[i]=vfree[i+1];
+            }
+            return line;
+        }
+        uint8_t lru=font_lru(true);
+        if (lru==FONTSLOTS)
+            return -1;
+        font_free(lru);
+    }
+}
+
+// give band back, merging it with free neighbours. returns false if the
+// free list is full, the band is lost then
+template <class T>
+bool VS23S010T<T>::vmem_free(int16_t line,uint16_t lines)
+{
+    if (!lines || line<0)
+        return true;
+    uint8_t i;
+    for (i=0;i<vfreecount && vfree[i].line<line;i++)
+        ;
+    bool prev=(i>0 && vfree[i-1].line+vfree[i-1].lines==line);
+    bool next=(i<vfreecount && line+lines==vfree[i].line);
+    if (prev && next) {
+        vfree[i-1].lines+=lines+vfree[i].lines;
+        vfreecount--;
+        for (;i<vfreecount;i++)
+            vfree[i]=vfree[i+1];
+    }
+    else if (prev)
+        vfree[i-1].lines+=lines;
+    else if (next) {
+        vfree[i].line=line;
+        vfree[i].lines+=lines;
+    }
+    else {
+        if (vfreecount==VMEM_FREE)
+            return false;
+        for (uint8_t j=vfreecount;j>i;j--)
+            vfree[j]=vfree[j-1];
+        vfree[i].line=line;
+        vfree[i].lines=lines;
+        vfreecount++;
+    }
+    return true;
+}
+
+template <class T>
+bool VS23S010T<T>::arena_init(vmem_arena_t *a,uint16_t lines)
+{
+    a->used=0;
+    a->line=vmem_alloc(lines);
+    a->lines=(a->line<0)?0:lines;
+    return a->line>=0;
+}
+
+// next lines from arena, -1 if there are not enough left
+template <class T>
+int16_t VS23S010T<T>::arena_alloc(vmem_arena_t *a,uint16_t lines)
+{
+    if (a->line<0 || a->lines-a->used<lines)
+        return -1;
+    a->used+=lines;
+    return a->line+a->used-lines;
+}
+
+template <class T>
+void VS23S010T<T>::arena_free(vmem_arena_t *a)
+{
+    vmem_free(a->line,a->lines);
+    a->line=-1;
+    a->lines=0;
+    a->used=0;
+}